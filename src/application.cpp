@@ -8,12 +8,13 @@
 #include "log.hpp"
 #include "utility.hpp"
 #include "material.hpp"
+#include "simulation.hpp"
 
 MemoryArena GlobalArena;
 MemoryArena TransientArena;
 
 #if DEBUG
-void ImGuiMemoryDiagnosticsWindow()
+void ImGuiMemoryDiagnosticsWindow(const Scene& scene)
 {
     ImGui::Begin("Memory diagnostics");
     ImGui::Text("Arena memory: %zu", MemoryArena::TotalAllocationSize);
@@ -25,6 +26,9 @@ void ImGuiMemoryDiagnosticsWindow()
     MemoryArena::MemoryInfo transientArenaInfo = TransientArena.GetMemoryInfo();
     ImGui::Text("Transient arena: %zu/%zu", transientArenaInfo.usedMemory, transientArenaInfo.allocatedMemory);
 
+    MemoryArena::MemoryInfo levelArenaInfo = scene.GetLevelArena().GetMemoryInfo();
+    ImGui::Text("Level arena: %zu/%zu", levelArenaInfo.usedMemory, levelArenaInfo.allocatedMemory);
+
     MemoryArena::MemoryInfo logArenaInfo = Log::GetArena()->GetMemoryInfo();
     ImGui::Text("Log arena: %zu/%zu", logArenaInfo.usedMemory, logArenaInfo.allocatedMemory);
 
@@ -46,8 +50,8 @@ bool Application::Init(GameState startGameState)
         return false;
     }
 
-    GlobalArena.Init(1'048'576, MemoryArenaFlags_ClearToZero);
-    TransientArena.Init(1'048'576, MemoryArenaFlags_ClearToZero);
+    GlobalArena.Init(1'048'576, MemoryArenaFlags_ClearToZero | MemoryArenaFlags_VirtualMemory);
+    TransientArena.Init(1'048'576, MemoryArenaFlags_ClearToZero | MemoryArenaFlags_VirtualMemory);
 
     if (!m_Renderer.Init(m_Window))
     {
@@ -55,8 +59,8 @@ bool Application::Init(GameState startGameState)
         return false;
     }
 
-    m_Scene.Init(&GlobalArena);
-    m_Menu.Init(&GlobalArena);
+    m_Scene.Init();
+    m_Menu.Init();
 
     LoadScene(firstSceneFilepath);
     m_GameState = startGameState;
@@ -66,7 +70,7 @@ bool Application::Init(GameState startGameState)
 
 bool Application::Loop(float deltaTime)
 {
-    constexpr float TARGET_DELTA_TIME = 1.0f / 60.0f;
+    constexpr float TARGET_DELTA_TIME = Simulation::TimeStep;
     static float timeAccumulation = 0.0f;
     timeAccumulation += deltaTime;
     if (timeAccumulation < TARGET_DELTA_TIME)
@@ -75,6 +79,15 @@ bool Application::Loop(float deltaTime)
     }
     timeAccumulation -= TARGET_DELTA_TIME;
 
+    // Every step reads the input exactly as it is recorded here, which is what makes replays match
+    if (m_InputReplay.IsActive() && !m_InputReplay.NextFrame(m_Input))
+    {
+        Log::Info("Input replay finished, back to live input");
+    }
+    m_InputRecorder.RecordFrame(m_Input);
+
+    Log::UpdateRateLimits();
+
     bool success = false;
     if (m_GameState == GameState::Editor)
     {
@@ -101,36 +114,34 @@ void Application::LoadScene(StringView sceneFilepath)
     m_Scene.Clear();
     m_Scene.Deserialize(ReadFile(sceneFilepath, &TransientArena));
 
-    Entity* playerEntity = m_Scene.CreateEntity();
-    playerEntity->material = MaterialManager::GetMaterial("player");
-    playerEntity->transform.position = Math::float2(0.0f, 0.0f);
-    playerEntity->transform.scale = Math::float2(0.1);
-    playerEntity->shape = Shape::Ellipse;
-    playerEntity->flags |= (uint16_t)EntityFlags::Player;
+    Entity* playerEntity = Simulation::SpawnPlayer(m_Scene);
+    playerEntity->material = MaterialManager::GetMaterial("player"_id);
     m_Player = Player(playerEntity);
 }
 
 Entity* GetHoveredEntity(const Scene& scene, Math::float2 worldPosition)
 {
     Entity* closestEntity = nullptr;
-    auto HitEntity = [&closestEntity](Entity* entity)
+    auto HitEntity = [&](Entity* entity)
     {
-        if (closestEntity == nullptr || entity->zIndex > closestEntity->zIndex)
+        if (closestEntity == nullptr || scene.GetZIndex(*entity) > scene.GetZIndex(*closestEntity))
         {
             closestEntity = entity;
         }
     };
 
-    for (Entity& entity : scene.entities)
+    auto TestEntity = [&](Entity* entityPtr)
     {
-        Math::float2 rotatedWorldPosition = entity.transform.position + Math::RotateVector(worldPosition - entity.transform.position, -entity.transform.rotation);
+        Entity& entity = *entityPtr;
+        Transform transform = scene.GetTransform(entity);
+        Math::float2 rotatedWorldPosition = transform.position + Math::RotateVector(worldPosition - transform.position, -transform.rotation);
         switch (entity.shape)
         {
             case Shape::Ellipse:
             {
                 float distanceSquared = Math::DistanceSquared(
-                    entity.transform.position / entity.transform.scale,
-                    rotatedWorldPosition / entity.transform.scale
+                    transform.position / transform.scale,
+                    rotatedWorldPosition / transform.scale
                 );
                 if (distanceSquared <= 1.0f)
                 {
@@ -140,8 +151,8 @@ Entity* GetHoveredEntity(const Scene& scene, Math::float2 worldPosition)
             }
             case Shape::Rectangle:
             {
-                Math::float2 min = entity.transform.position - entity.transform.scale;
-                Math::float2 max = entity.transform.position + entity.transform.scale;
+                Math::float2 min = transform.position - transform.scale;
+                Math::float2 max = transform.position + transform.scale;
                 if (rotatedWorldPosition.x >= min.x && rotatedWorldPosition.y >= min.y &&
                     rotatedWorldPosition.x <= max.x && rotatedWorldPosition.y <= max.y)
                 {
@@ -152,6 +163,13 @@ Entity* GetHoveredEntity(const Scene& scene, Math::float2 worldPosition)
             default:
                 Log::Warn("Invalid shape: %", (int)entity.shape);
         }
+    };
+
+    // Entities untouched since the level loaded are in the static BVH, the rest are checked one by one
+    scene.GetStaticEntities().Query({ .min = worldPosition, .max = worldPosition }, TestEntity);
+    for (Entity* entity : scene.GetDynamicEntities())
+    {
+        TestEntity(entity);
     }
     return closestEntity;
 }
@@ -186,8 +204,11 @@ bool Application::LoopEditor(float deltaTime)
         mouseWorldPosition = Math::Floor(mouseWorldPosition * 100.0f) / 100.0f;
     }
 
-    static Entity* inspectedEntity = nullptr;
-    static Entity* templateEntity = nullptr;
+    // Held as handles, so destroying the entities or loading another scene leaves them null instead of dangling
+    static EntityHandle inspectedHandle;
+    static EntityHandle templateHandle;
+    Entity* inspectedEntity = m_Scene.GetEntity(inspectedHandle);
+    Entity* templateEntity = m_Scene.GetEntity(templateHandle);
     if (m_Input.IsMousePressed())
     {
         inspectedEntity = GetHoveredEntity(m_Scene, mouseWorldPosition);
@@ -200,23 +221,24 @@ bool Application::LoopEditor(float deltaTime)
     if (m_Input.IsKeyPressed(SDL_SCANCODE_N))
     {
         inspectedEntity = m_Scene.CreateEntity();
-        inspectedEntity->transform.position = mouseWorldPosition;
-        inspectedEntity->transform.scale = 0.1f;
+        Transform transform(mouseWorldPosition, 0.1f);
 
         if (templateEntity != nullptr)
         {
-            inspectedEntity->flags = templateEntity->flags;
-            inspectedEntity->zIndex = templateEntity->zIndex;
-            inspectedEntity->transform.scale = templateEntity->transform.scale;
-            inspectedEntity->transform.rotation = templateEntity->transform.rotation;
+            Transform templateTransform = m_Scene.GetTransform(*templateEntity);
+            m_Scene.SetFlags(inspectedEntity, m_Scene.GetFlags(*templateEntity));
+            m_Scene.SetZIndex(inspectedEntity, m_Scene.GetZIndex(*templateEntity));
+            transform.scale = templateTransform.scale;
+            transform.rotation = templateTransform.rotation;
             inspectedEntity->material = templateEntity->material;
             inspectedEntity->shape = templateEntity->shape;
             inspectedEntity->gravityZone = templateEntity->gravityZone;
             if (m_Input.IsKeyDown(SDL_SCANCODE_LSHIFT))
             {
-                inspectedEntity->transform.position = templateEntity->transform.position;
+                transform.position = templateTransform.position;
             }
         }
+        m_Scene.SetTransform(inspectedEntity, transform);
     }
 
     if (inspectedEntity != nullptr && m_Input.IsKeyPressed(SDL_SCANCODE_BACKSPACE))
@@ -225,9 +247,11 @@ bool Application::LoopEditor(float deltaTime)
         inspectedEntity = nullptr;
         templateEntity = nullptr;
     }
+    inspectedHandle = inspectedEntity != nullptr ? inspectedEntity->handle : EntityHandle{};
+    templateHandle = templateEntity != nullptr ? templateEntity->handle : EntityHandle{};
 
 #if DEBUG
-    ImGuiMemoryDiagnosticsWindow();
+    ImGuiMemoryDiagnosticsWindow(m_Scene);
 
     ImGui::Begin("Material properties");
 
@@ -260,11 +284,11 @@ bool Application::LoopEditor(float deltaTime)
         {
             // TODO: Is this necessary?
             uniformName.Clear();
-            uniformName += key;
+            uniformName += key.GetString();
             uniformName.NullTerminate();
 
             #define CASE(DATA_TYPE, CAST_TYPE, INPUT_FUNC) { \
-                auto data = material->GetUniform<DATA_TYPE>(uniformName); \
+                auto data = material->GetUniform<DATA_TYPE>(key); \
                 assert(data != nullptr); \
                 if (ImGui::INPUT_FUNC(uniformName.data, (CAST_TYPE*)data, (CAST_TYPE)0.01f)) \
                 { \
@@ -305,10 +329,10 @@ bool Application::LoopEditor(float deltaTime)
     {
         // ImGui::InputText("Name:", &inspectedEntity->name);
 
-        ImGui::Text("ID: %i", inspectedEntity->id);
+        ImGui::Text("Handle: %u (generation %u)", inspectedEntity->handle.GetIndex(), inspectedEntity->handle.GetGeneration());
 
         char buffer[100] {};
-        memcpy(buffer, inspectedEntity->name.data, Math::Min(sizeof(buffer) - 1, inspectedEntity->name.size));
+        memcpy(buffer, inspectedEntity->name.Data(), Math::Min(sizeof(buffer) - 1, inspectedEntity->name.size));
         if (ImGui::InputText("Name", buffer, sizeof(buffer)))
         {
             // TODO: Make a proper String overload similar to imgui_stdlib
@@ -316,26 +340,30 @@ bool Application::LoopEditor(float deltaTime)
             inspectedEntity->name += buffer;
         }
 
-        ImGuiFlag("Flag: Collider",     inspectedEntity->flags, (uint16_t)EntityFlags::Collider);
-        ImGuiFlag("Flag: Gravity Zone", inspectedEntity->flags, (uint16_t)EntityFlags::GravityZone);
-        ImGuiFlag("Flag: Text",         inspectedEntity->flags, (uint16_t)EntityFlags::Text);
-        ImGuiFlag("Flag: Hidden",       inspectedEntity->flags, (uint16_t)EntityFlags::Hidden);
-        ImGuiFlag("Flag: Light",        inspectedEntity->flags, (uint16_t)EntityFlags::Light);
-        ImGuiFlag("Flag: Lava",         inspectedEntity->flags, (uint16_t)EntityFlags::Lava);
-        ImGuiFlag("Flag: Death Zone",   inspectedEntity->flags, (uint16_t)EntityFlags::DeathZone);
-        ImGuiFlag("Flag: Checkpoint",   inspectedEntity->flags, (uint16_t)EntityFlags::Checkpoint);
-        ImGuiFlag("Flag: Exit",         inspectedEntity->flags, (uint16_t)EntityFlags::Exit);
-
-        int zIndex = inspectedEntity->zIndex;
+        uint16_t flags = m_Scene.GetFlags(*inspectedEntity);
+        ImGuiFlag("Flag: Collider",     flags, (uint16_t)EntityFlags::Collider);
+        ImGuiFlag("Flag: Gravity Zone", flags, (uint16_t)EntityFlags::GravityZone);
+        ImGuiFlag("Flag: Text",         flags, (uint16_t)EntityFlags::Text);
+        ImGuiFlag("Flag: Hidden",       flags, (uint16_t)EntityFlags::Hidden);
+        ImGuiFlag("Flag: Light",        flags, (uint16_t)EntityFlags::Light);
+        ImGuiFlag("Flag: Lava",         flags, (uint16_t)EntityFlags::Lava);
+        ImGuiFlag("Flag: Death Zone",   flags, (uint16_t)EntityFlags::DeathZone);
+        ImGuiFlag("Flag: Checkpoint",   flags, (uint16_t)EntityFlags::Checkpoint);
+        ImGuiFlag("Flag: Exit",         flags, (uint16_t)EntityFlags::Exit);
+        m_Scene.SetFlags(inspectedEntity, flags);
+
+        int zIndex = m_Scene.GetZIndex(*inspectedEntity);
         ImGui::InputInt("Z-index", &zIndex);
-        inspectedEntity->zIndex = zIndex;
+        m_Scene.SetZIndex(inspectedEntity, zIndex);
 
-        ImGui::DragFloat2("Position", (float*)&inspectedEntity->transform.position, 0.01);
-        ImGui::DragFloat2("Scale", (float*)&inspectedEntity->transform.scale, 0.01);
+        Transform transform = m_Scene.GetTransform(*inspectedEntity);
+        ImGui::DragFloat2("Position", (float*)&transform.position, 0.01);
+        ImGui::DragFloat2("Scale", (float*)&transform.scale, 0.01);
 
-        int rotation = std::roundf(inspectedEntity->transform.rotation * Math::RAD_TO_DEG);
+        int rotation = std::roundf(transform.rotation * Math::RAD_TO_DEG);
         ImGui::DragInt("Rotation", &rotation);
-        inspectedEntity->transform.rotation = (float)rotation * Math::DEG_TO_RAD;
+        transform.rotation = (float)rotation * Math::DEG_TO_RAD;
+        m_Scene.SetTransform(inspectedEntity, transform);
 
         String materialName = String::Copy(inspectedEntity->material->name, &TransientArena);
         materialName.NullTerminate();
@@ -367,7 +395,7 @@ bool Application::LoopEditor(float deltaTime)
             ImGui::EndCombo();
         }
 
-        if (inspectedEntity->flags & (uint16_t)EntityFlags::GravityZone)
+        if (flags & (uint16_t)EntityFlags::GravityZone)
         {
             if (inspectedEntity->shape == Shape::Ellipse)
             {
@@ -528,7 +556,7 @@ bool Application::LoopMainMenu(float deltaTime)
     m_Scene.EndFrame();
 
 #if DEBUG
-    ImGuiMemoryDiagnosticsWindow();
+    ImGuiMemoryDiagnosticsWindow(m_Scene);
 #endif
 
     m_Renderer.Resize();
@@ -546,30 +574,10 @@ bool Application::LoopGame(float deltaTime)
 
     if (m_GameState == GameState::Game)
     {
-        bool finishedLevel = false;
-        m_Player.Update(m_Scene, m_Camera.transform.rotation, m_Renderer.GetTime(), m_Input, &finishedLevel);
-        if (finishedLevel)
+        if (Simulation::Step(m_Scene, m_Player, m_Camera, m_Input, m_Renderer.GetTime()))
         {
             m_GameState = GameState::FinishingLevel;
         }
-
-        Math::float2 down = m_Scene.properties.flags & (uint32_t)Scene::Properties::Flags::LockCameraRotation ?
-            Math::float2(0, -1) : m_Player.gravityDirection;
-
-        Math::float2 right = m_Scene.properties.flags & (uint32_t)Scene::Properties::Flags::LockCameraRotation ?
-            Math::float2(1, 0) : Math::float2{ -m_Player.gravityDirection.y, m_Player.gravityDirection.x };
-
-        Math::float2 cameraOffset = { 0.0f, 0.3f };
-        cameraOffset.x = (std::exp(Math::Dot(m_Player.velocity, right)) - 1.0f) * 20.0f;
-        m_Camera.FollowPlayer(m_Player.GetTransform().position, cameraOffset, down, deltaTime);
-        if (m_Scene.properties.flags & (uint32_t)Scene::Properties::Flags::LockCameraY)
-        {
-            m_Camera.transform.position.y = 0.0f;
-        }
-        if (m_Scene.properties.flags & (uint32_t)Scene::Properties::Flags::LockCameraRotation)
-        {
-            m_Camera.transform.rotation = 0.0f;
-        }
     }
     else
     {
@@ -585,12 +593,12 @@ bool Application::LoopGame(float deltaTime)
     m_Scene.EndFrame();
 
 #if DEBUG
-    ImGuiMemoryDiagnosticsWindow();
+    ImGuiMemoryDiagnosticsWindow(m_Scene);
 
     ImGui::Text("CPU: %fms", frameTime);
     ImGui::Text("Delta time: %fms", deltaTime * 1000.0f);
     ImGui::Text("Camera position: (%f, %f)", m_Camera.transform.position.x, m_Camera.transform.position.y);
-    ImGui::Text("Player position: (%f, %f)", m_Player.GetTransform().position.x, m_Player.GetTransform().position.y);
+    ImGui::Text("Player position: (%f, %f)", m_Player.GetTransform(m_Scene).position.x, m_Player.GetTransform(m_Scene).position.y);
     ImGui::Text("Player velocity: (%f, %f)", m_Player.velocity.x, m_Player.velocity.y);
     ImGui::Text("Player speed: %f", Math::Length(m_Player.velocity));
     ImGui::DragFloat("Player acceleration", &m_Player.acceleration, 0.001f);
@@ -615,14 +623,35 @@ bool Application::LoopGame(float deltaTime)
 
 void Application::Exit()
 {
+    m_InputRecorder.Stop();
     SDL_DestroyWindow(m_Window);
 }
 
+bool Application::StartInputRecording(const char* filePath)
+{
+    return m_InputRecorder.Start(filePath, (uint32_t)m_GameState);
+}
+
+bool Application::StartInputReplay(const char* filePath)
+{
+    if (!m_InputReplay.Load(filePath, &GlobalArena))
+    {
+        return false;
+    }
+    m_GameState = (GameState)m_InputReplay.GetStartState();
+    return true;
+}
+
 void Application::OnEvent(const SDL_Event& event)
 {
 #if DEBUG
     ImGui_ImplSDL3_ProcessEvent(&event);
 #endif
+    // The replay is the only source of input until it runs out
+    if (m_InputReplay.IsActive())
+    {
+        return;
+    }
     switch (event.type)
     {
         case SDL_EVENT_MOUSE_MOTION:
@@ -9,14 +9,9 @@
 #include "player.hpp"
 #include "menu.hpp"
 #include "input.hpp"
+#include "input-recording.hpp"
 #include "memory-arena.hpp"
 
-// Memory allocated with this arena will persist for the entire duration of the program
-extern MemoryArena GlobalArena;
-
-// Memory allocated in this arena will be cleared at the beginning of every frame
-extern MemoryArena TransientArena;
-
 enum class GameState
 {
     MainMenu_MainMenu = 1 << 0,
@@ -41,6 +36,10 @@ public:
 
     void LoadScene(StringView sceneName);
 
+    // Call right after Init(), so the recording or replay covers every step of the session
+    bool StartInputRecording(const char* filePath);
+    bool StartInputReplay(const char* filePath);
+
     void OnEvent(const SDL_Event& event);
 
 private:
@@ -52,6 +51,8 @@ private:
     SDL_Window* m_Window = nullptr;
     Renderer m_Renderer;
     Input m_Input;
+    InputRecording::Recorder m_InputRecorder;
+    InputRecording::Replay m_InputReplay;
 
     std::array<int, 2> m_ActiveControlRebind = { -1, -1 };
 
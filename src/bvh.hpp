@@ -0,0 +1,375 @@
+#pragma once
+
+#include <algorithm>
+
+#include "data-structures.hpp"
+#include "math.hpp"
+
+/*
+    Bounding volume hierarchy over axis aligned bounding boxes, built once from items that rarely move:
+    - Build() splits each node at the cheapest of a few binned surface area heuristic candidates along its longest axis
+    - Items are identified by a dense id, such as EntityHandle::GetIndex(), like in SpatialGrid
+    - Remove() only clears the item out of its leaf, node bounds are not shrunk until the next Build()
+    - Query() calls back once per item whose bounds overlap, Cast() calls back once per leaf the moving box enters,
+      nearest leaf first, and skips leaves entered after the time the callback returns
+*/
+
+template<typename T>
+struct Bvh
+{
+    static constexpr uint32_t MaxLeafSize = 8;
+    static constexpr int BinCount = 12;
+    static constexpr uint32_t NullSlot = UINT32_MAX;
+
+    // Deeper nodes are split at the median, which bounds the depth and so the traversal stack
+    static constexpr int MaxHeuristicDepth = 32;
+    static constexpr int MaxStackSize = 64;
+
+    MemoryArena* arena = nullptr;
+
+    struct Item
+    {
+        uint32_t id = 0;
+        T* value = nullptr;
+        Math::AABB bounds{};
+    };
+
+    struct Node
+    {
+        Math::AABB bounds{};
+        // First child for inner nodes, whose second child follows it, first slot for leaves
+        uint32_t first = 0;
+        // Zero for inner nodes
+        uint32_t count = 0;
+    };
+
+    Array<Node> nodes;
+
+    // Items of each leaf are stored contiguously, removed items leave a nullptr behind
+    Array<T*> slotValues;
+    Array<Math::AABB> slotBounds;
+    Array<uint32_t> idSlots;
+
+    size_t size = 0;
+
+    // Reorders items while partitioning them
+    inline void Build(Span<Item> items)
+    {
+        Clear();
+        SetArenas();
+        if (items.size == 0)
+        {
+            return;
+        }
+
+        nodes.Reserve(2 * (items.size / MaxLeafSize + 1));
+        nodes.Push(Node{});
+        BuildNode(0, items, 0, items.size, 0);
+
+        slotValues.Resize(items.size);
+        slotBounds.Resize(items.size);
+        for (size_t slot = 0; slot < items.size; slot++)
+        {
+            const Item& item = items[slot];
+            slotValues[slot] = item.value;
+            slotBounds[slot] = item.bounds;
+            while (idSlots.size <= item.id)
+            {
+                idSlots.Push(NullSlot);
+            }
+            assert(idSlots[item.id] == NullSlot && "Item ids must be unique");
+            idSlots[item.id] = slot;
+        }
+        size = items.size;
+    }
+
+    inline void Remove(uint32_t id)
+    {
+        assert(Contains(id));
+        slotValues[idSlots[id]] = nullptr;
+        idSlots[id] = NullSlot;
+        size--;
+    }
+
+    inline bool Contains(uint32_t id) const
+    {
+        return id < idSlots.size && idSlots[id] != NullSlot;
+    }
+
+    // Bounds the item was built with
+    inline const Math::AABB& GetBounds(uint32_t id) const
+    {
+        assert(Contains(id));
+        return slotBounds[idSlots[id]];
+    }
+
+    template<typename F>
+    inline void Query(const Math::AABB& bounds, F&& callback) const
+    {
+        if (size == 0)
+        {
+            return;
+        }
+
+        uint32_t stack[MaxStackSize];
+        int stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize > 0)
+        {
+            const Node& node = nodes[stack[--stackSize]];
+            if (!Math::Overlaps(node.bounds, bounds))
+            {
+                continue;
+            }
+            if (node.count == 0)
+            {
+                assert(stackSize + 2 <= MaxStackSize);
+                stack[stackSize++] = node.first;
+                stack[stackSize++] = node.first + 1;
+                continue;
+            }
+            for (uint32_t slot = node.first; slot < node.first + node.count; slot++)
+            {
+                if (slotValues[slot] != nullptr && Math::Overlaps(slotBounds[slot], bounds))
+                {
+                    callback(slotValues[slot]);
+                }
+            }
+        }
+    }
+
+    // Moves box along velocity for times in [0, 1]. callback(Span<T*> leaf) returns the time past which
+    // later leaves can be skipped, such as the closest hit so far. The leaf can contain nullptrs of removed items.
+    template<typename F>
+    inline void Cast(const Math::AABB& box, Math::float2 velocity, F&& callback) const
+    {
+        if (size == 0)
+        {
+            return;
+        }
+
+        Math::float2 origin = (box.min + box.max) * 0.5f;
+        Math::float2 halfSize = (box.max - box.min) * 0.5f;
+        float maxT = 1.0f;
+
+        auto GetEnterTime = [&](const Node& node, float& enterTime)
+        {
+            return EnterTime({ .min = node.bounds.min - halfSize, .max = node.bounds.max + halfSize }, origin, velocity, maxT, enterTime);
+        };
+
+        struct Entry
+        {
+            uint32_t node;
+            float enterTime;
+        };
+        Entry stack[MaxStackSize];
+        int stackSize = 0;
+
+        float rootEnterTime;
+        if (GetEnterTime(nodes[0], rootEnterTime))
+        {
+            stack[stackSize++] = { 0, rootEnterTime };
+        }
+        while (stackSize > 0)
+        {
+            Entry entry = stack[--stackSize];
+            if (entry.enterTime > maxT)
+            {
+                continue;
+            }
+            const Node& node = nodes[entry.node];
+            if (node.count > 0)
+            {
+                maxT = Math::Min(maxT, (float)callback(Span<T*>(slotValues.data + node.first, node.count)));
+                continue;
+            }
+
+            float enterTimes[2];
+            bool entered[2] = {
+                GetEnterTime(nodes[node.first], enterTimes[0]),
+                GetEnterTime(nodes[node.first + 1], enterTimes[1])
+            };
+            // The nearer child goes on top of the stack
+            int nearer = (entered[0] && (!entered[1] || enterTimes[0] <= enterTimes[1])) ? 0 : 1;
+            int farther = 1 - nearer;
+            assert(stackSize + 2 <= MaxStackSize);
+            if (entered[farther])
+            {
+                stack[stackSize++] = { node.first + farther, enterTimes[farther] };
+            }
+            if (entered[nearer])
+            {
+                stack[stackSize++] = { node.first + nearer, enterTimes[nearer] };
+            }
+        }
+    }
+
+    // Keeps the memory of the arrays around
+    inline void Clear()
+    {
+        nodes.Resize(0);
+        slotValues.Resize(0);
+        slotBounds.Resize(0);
+        idSlots.Resize(0);
+        size = 0;
+    }
+
+private:
+    inline void SetArenas()
+    {
+        nodes.arena = arena;
+        slotValues.arena = arena;
+        slotBounds.arena = arena;
+        idSlots.arena = arena;
+    }
+
+    // Half the perimeter, the 2D counterpart of surface area
+    static inline float GetCost(const Math::AABB& bounds)
+    {
+        return (bounds.max.x - bounds.min.x) + (bounds.max.y - bounds.min.y);
+    }
+
+    static inline float GetCentroid(const Math::AABB& bounds, int axis)
+    {
+        return axis == 0 ? bounds.min.x + bounds.max.x : bounds.min.y + bounds.max.y;
+    }
+
+    // Slab test of the segment origin + velocity * t against bounds, for t in [0, maxT]
+    static inline bool EnterTime(const Math::AABB& bounds, Math::float2 origin, Math::float2 velocity, float maxT, float& enterTime)
+    {
+        float tMin = 0.0f;
+        float tMax = maxT;
+        for (int axis = 0; axis < 2; axis++)
+        {
+            float o = axis == 0 ? origin.x : origin.y;
+            float v = axis == 0 ? velocity.x : velocity.y;
+            float min = axis == 0 ? bounds.min.x : bounds.min.y;
+            float max = axis == 0 ? bounds.max.x : bounds.max.y;
+            if (v == 0.0f)
+            {
+                if (o < min || o > max)
+                {
+                    return false;
+                }
+                continue;
+            }
+            float t0 = (min - o) / v;
+            float t1 = (max - o) / v;
+            tMin = Math::Max(tMin, Math::Min(t0, t1));
+            tMax = Math::Min(tMax, Math::Max(t0, t1));
+        }
+        enterTime = tMin;
+        return tMin <= tMax;
+    }
+
+    inline void BuildNode(uint32_t nodeIndex, Span<Item> items, size_t begin, size_t end, int depth)
+    {
+        // Centroids are kept doubled, which saves a multiply and doesn't change the split
+        Math::float2 firstCentroid = items[begin].bounds.min + items[begin].bounds.max;
+        Math::AABB bounds = items[begin].bounds;
+        Math::AABB centroidBounds = { .min = firstCentroid, .max = firstCentroid };
+        for (size_t i = begin; i < end; i++)
+        {
+            bounds = Math::Union(bounds, items[i].bounds);
+            Math::float2 centroid = items[i].bounds.min + items[i].bounds.max;
+            centroidBounds = Math::Union(centroidBounds, { .min = centroid, .max = centroid });
+        }
+        nodes[nodeIndex].bounds = bounds;
+
+        size_t count = end - begin;
+        if (count <= MaxLeafSize)
+        {
+            nodes[nodeIndex].first = begin;
+            nodes[nodeIndex].count = count;
+            return;
+        }
+
+        Math::float2 centroidExtent = centroidBounds.max - centroidBounds.min;
+        int axis = centroidExtent.x >= centroidExtent.y ? 0 : 1;
+        float axisMin = axis == 0 ? centroidBounds.min.x : centroidBounds.min.y;
+        float axisExtent = axis == 0 ? centroidExtent.x : centroidExtent.y;
+
+        size_t middle = begin;
+        if (axisExtent > 0.0f && depth < MaxHeuristicDepth)
+        {
+            auto GetBin = [&](const Item& item)
+            {
+                int bin = (int)((GetCentroid(item.bounds, axis) - axisMin) / axisExtent * BinCount);
+                return std::clamp(bin, 0, BinCount - 1);
+            };
+
+            uint32_t binCounts[BinCount] = {};
+            Math::AABB binBounds[BinCount];
+            for (size_t i = begin; i < end; i++)
+            {
+                int bin = GetBin(items[i]);
+                binBounds[bin] = binCounts[bin] == 0 ? items[i].bounds : Math::Union(binBounds[bin], items[i].bounds);
+                binCounts[bin]++;
+            }
+
+            // Cost of splitting after each bin, accumulated from the right and then swept from the left
+            float rightCosts[BinCount];
+            uint32_t rightCount = 0;
+            Math::AABB rightBounds{};
+            for (int bin = BinCount - 1; bin > 0; bin--)
+            {
+                if (binCounts[bin] > 0)
+                {
+                    rightBounds = rightCount == 0 ? binBounds[bin] : Math::Union(rightBounds, binBounds[bin]);
+                    rightCount += binCounts[bin];
+                }
+                rightCosts[bin - 1] = rightCount == 0 ? 0.0f : rightCount * GetCost(rightBounds);
+            }
+
+            int bestSplit = -1;
+            float bestCost = INFINITY;
+            uint32_t leftCount = 0;
+            Math::AABB leftBounds{};
+            for (int bin = 0; bin < BinCount - 1; bin++)
+            {
+                if (binCounts[bin] > 0)
+                {
+                    leftBounds = leftCount == 0 ? binBounds[bin] : Math::Union(leftBounds, binBounds[bin]);
+                    leftCount += binCounts[bin];
+                }
+                if (leftCount == 0 || leftCount == count)
+                {
+                    continue;
+                }
+                float cost = leftCount * GetCost(leftBounds) + rightCosts[bin];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestSplit = bin;
+                }
+            }
+
+            if (bestSplit >= 0)
+            {
+                Item* split = std::partition(items.data + begin, items.data + end, [&](const Item& item)
+                {
+                    return GetBin(item) <= bestSplit;
+                });
+                middle = split - items.data;
+            }
+        }
+
+        if (middle == begin || middle == end)
+        {
+            // Identical centroids or too deep for the heuristic, a median split keeps the tree balanced
+            middle = begin + count / 2;
+            std::nth_element(items.data + begin, items.data + middle, items.data + end, [&](const Item& a, const Item& b)
+            {
+                return GetCentroid(a.bounds, axis) < GetCentroid(b.bounds, axis);
+            });
+        }
+
+        uint32_t firstChild = nodes.size;
+        nodes.Push(Node{});
+        nodes.Push(Node{});
+        nodes[nodeIndex].first = firstChild;
+        nodes[nodeIndex].count = 0;
+        BuildNode(firstChild, items, begin, middle, depth + 1);
+        BuildNode(firstChild + 1, items, middle, end, depth + 1);
+    }
+};
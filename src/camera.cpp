@@ -20,7 +20,7 @@ void Camera::FollowPlayer(Math::float2 position, Math::float2 offset, Math::floa
     constexpr float rotationHalfLifeSeconds = 0.05f;
     constexpr float positionHalfLifeSeconds = 0.15f;
 
-    float targetRotation = std::atan2f(down.y, down.x) + Math::PI / 2.0f;
+    float targetRotation = std::atan2(down.y, down.x) + Math::PI / 2.0f;
     transform.rotation = Math::LerpAngleSmooth(transform.rotation, targetRotation, deltaTime, rotationHalfLifeSeconds);
 
     Math::float2 targetPosition = position + Math::RotateVector(offset, transform.rotation);
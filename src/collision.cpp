@@ -0,0 +1,378 @@
+#include "collision.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+namespace Physics
+{
+    ColliderGeometry ColliderGeometry::FromTransform(const Transform& transform)
+    {
+        ColliderGeometry geometry;
+        geometry.transform = transform;
+        geometry.rotation = Math::Complex::FromAngle(transform.rotation);
+        geometry.inverseRotation = Math::Complex::FromAngle(-transform.rotation);
+        geometry.corners = {
+            transform.position + geometry.rotation * -transform.scale,
+            transform.position + geometry.rotation * Math::float2(transform.scale.x, -transform.scale.y),
+            transform.position + geometry.rotation * transform.scale,
+            transform.position + geometry.rotation * Math::float2(-transform.scale.x, transform.scale.y)
+        };
+        geometry.bounds = transform.GetBounds();
+        geometry.downDirection = Math::Direction(transform.rotation - Math::PI / 2.0f);
+        return geometry;
+    }
+
+    bool ColliderGeometry::IsBuiltFrom(const Transform& other) const
+    {
+        return transform.position.x == other.position.x && transform.position.y == other.position.y &&
+               transform.scale.x == other.scale.x && transform.scale.y == other.scale.y &&
+               transform.rotation == other.rotation;
+    }
+
+    void RectBatch::Push(const ColliderGeometry& rect)
+    {
+        assert(!IsFull());
+        for (int i = 0; i < 4; i++)
+        {
+            cornerX[i][count] = rect.corners[i].x;
+            cornerY[i][count] = rect.corners[i].y;
+        }
+        count++;
+    }
+
+    CollisionData CirclePointCollision(Math::float2 circlePosition, Math::float2 velocity, Math::float2 point)
+    {
+        float a = Math::LengthSquared(velocity);
+        float b = Math::Dot(2 * velocity, circlePosition - point);
+        float c = Math::LengthSquared(circlePosition - point) - 1.0f;
+
+        Math::float2 solutions;
+        if (!Math::SolveQuadratic(a, b, c, solutions))
+        {
+            return { .collided = false };
+        }
+
+        float t = INFINITY;
+        for (int i = 0; i < 2; i++)
+        {
+            if (solutions[i] >= 0 && solutions[i] <= 1)
+            {
+                t = std::min(t, solutions[i]);
+            }
+        }
+
+        if (t == INFINITY)
+        {
+            return CollisionData { .collided = false };
+        }
+        assert(t >= 0 && t <= 1);
+        return CollisionData {
+            .collided = true,
+            .contactPoint = point,
+            .normal = Math::Normalize(circlePosition + velocity * t - point),
+            .t = t
+        };
+    }
+
+    CollisionData CircleLineCollision(Math::float2 circlePosition, Math::float2 velocity, const Line& line)
+    {
+        Math::float2 edge = line.to - line.from;
+        Math::float2 baseToVertex = line.from - circlePosition;
+
+        float edgeLengthSq = Math::LengthSquared(edge);
+        float edgeDotVelocity = Math::Dot(edge, velocity);
+        float edgeDotBaseToVertex = Math::Dot(edge, baseToVertex);
+
+        float a = edgeLengthSq * -Math::LengthSquared(velocity) + edgeDotVelocity * edgeDotVelocity;
+        float b = edgeLengthSq * 2.0f * Math::Dot(velocity, baseToVertex) - 2.0f * edgeDotVelocity * edgeDotBaseToVertex;
+        float c = edgeLengthSq * (1.0f - Math::LengthSquared(baseToVertex)) + edgeDotBaseToVertex * edgeDotBaseToVertex;
+
+        Math::float2 solutions;
+        if (!Math::SolveQuadratic(a, b, c, solutions))
+        {
+            return { .collided = false };
+        }
+
+        Math::float2 intersectionPoint;
+
+        float t = INFINITY;
+        for (int i = 0; i < 2; i++)
+        {
+            float f = (edgeDotVelocity * solutions[i] - edgeDotBaseToVertex) / edgeLengthSq;
+            if (solutions[i] >= 0 && solutions[i] <= 1 && f >= 0 && f <= 1 && solutions[i] < t)
+            {
+                t = solutions[i];
+                intersectionPoint = line.from + f * edge;
+            }
+        }
+
+        if (t == INFINITY)
+        {
+            return CollisionData { .collided = false };
+        }
+        assert(t >= 0 && t <= 1);
+        return CollisionData {
+            .collided = true,
+            .contactPoint = intersectionPoint,
+            .normal = Math::Normalize(circlePosition - intersectionPoint),
+            .t = t
+        };
+    }
+
+    CollisionData EllipseRectCollision(Transform ellipse, Math::float2 velocity, const ColliderGeometry& rect)
+    {
+        ellipse.position /= ellipse.scale;
+        velocity /= ellipse.scale;
+
+        std::array<Math::float2, 4> corners;
+        for (int i = 0; i < (int)corners.size(); i++)
+        {
+            corners[i] = rect.corners[i] / ellipse.scale;
+        }
+
+        CollisionData minCollision { .collided = false, .t = INFINITY };
+        for (int i = 0; i < (int)corners.size(); i++)
+        {
+            Math::float2 corner = corners[i];
+            Math::float2 nextCorner = corners[(i + 1) % corners.size()];
+
+            CollisionData collision;
+            collision = CirclePointCollision(ellipse.position, velocity, corner);
+            if (collision.collided && collision.t < minCollision.t)
+            {
+                minCollision = collision;
+            }
+
+            collision = CircleLineCollision(ellipse.position, velocity, Line{ corner, nextCorner });
+            if (collision.collided && collision.t < minCollision.t)
+            {
+                minCollision = collision;
+            }
+        }
+
+        minCollision.contactPoint *= ellipse.scale;
+        minCollision.normal = Math::Normalize(minCollision.normal / ellipse.scale);
+
+        return minCollision;
+    }
+
+    CollisionData EllipseRectCollision(const Transform& ellipse, Math::float2 velocity, const Transform& rect)
+    {
+        return EllipseRectCollision(ellipse, velocity, ColliderGeometry::FromTransform(rect));
+    }
+
+    Math::AABB GetEllipseBounds(const Transform& ellipse)
+    {
+        float radius = std::abs(ellipse.scale.x);
+        Math::AABB circle = { .min = ellipse.position - radius, .max = ellipse.position + radius };
+        return Math::Union(ellipse.GetBounds(), circle);
+    }
+
+    CollisionData CircleCircleCollision(const Transform& circle, Math::float2 velocity, const Transform& other)
+    {
+        const float circleRadius = circle.scale.x;
+        const float otherRadius = other.scale.x;
+
+        float targetDist = circleRadius + otherRadius;
+
+        float a = Math::LengthSquared(velocity);
+        float b = Math::Dot(2 * velocity, circle.position - other.position);
+        float c = Math::LengthSquared(circle.position - other.position) - targetDist * targetDist;
+
+        Math::float2 solutions;
+        if (!Math::SolveQuadratic(a, b, c, solutions))
+        {
+            return { .collided = false };
+        }
+
+        float t = INFINITY;
+        for (int i = 0; i < 2; i++)
+        {
+            if (solutions[i] >= 0.0f && solutions[i] <= 1.0f)
+            {
+                t = std::min(solutions[i], t);
+            }
+        }
+
+        if (t == INFINITY)
+        {
+            return { .collided = false };
+        }
+
+        Math::float2 normal = Math::Normalize(circle.position + velocity * t - other.position);
+        return CollisionData {
+            .collided = true,
+            .contactPoint = other.position - normal * otherRadius,
+            .normal = normal,
+            .t = t
+        };
+    }
+
+    CollisionData EllipseRectCollisionBatch(const Transform& ellipse, Math::float2 velocity, const RectBatch& rects, size_t* hitIndex)
+    {
+        using Simd::Float4;
+        using Simd::Mask4;
+
+        CollisionData minCollision { .collided = false, .t = INFINITY };
+        if (rects.count == 0)
+        {
+            return minCollision;
+        }
+
+        // Mirrors EllipseRectCollision() step by step, in the space where the ellipse is a unit circle
+        Math::float2 position = ellipse.position / ellipse.scale;
+        velocity /= ellipse.scale;
+
+        const Float4 zero = Float4::Broadcast(0.0f);
+        const Float4 one = Float4::Broadcast(1.0f);
+        const Float4 two = Float4::Broadcast(2.0f);
+        const Float4 four = Float4::Broadcast(4.0f);
+        const Float4 infinity = Float4::Broadcast(INFINITY);
+
+        const Float4 px = Float4::Broadcast(position.x);
+        const Float4 py = Float4::Broadcast(position.y);
+        const Float4 vx = Float4::Broadcast(velocity.x);
+        const Float4 vy = Float4::Broadcast(velocity.y);
+        const Float4 ellipseScaleX = Float4::Broadcast(ellipse.scale.x);
+        const Float4 ellipseScaleY = Float4::Broadcast(ellipse.scale.y);
+
+        const float velocityLengthSq = Math::LengthSquared(velocity);
+        const Float4 pointA = Float4::Broadcast(velocityLengthSq);
+        const Float4 pointInvTwoA = Float4::Broadcast(1.0f / (2.0f * velocityLengthSq));
+        const Float4 negVelocityLengthSq = Float4::Broadcast(-velocityLengthSq);
+
+        Math::float2 bestNormal = 0.0f;
+        for (size_t base = 0; base < rects.count; base += 4)
+        {
+            // The last group is padded with copies of the last rectangle, those lanes are skipped when picking the closest hit
+            auto Load = [&](const float* data)
+            {
+                if (base + 4 <= rects.count)
+                {
+                    return Float4::Load(data + base);
+                }
+                float lanes[4];
+                for (size_t i = 0; i < 4; i++)
+                {
+                    lanes[i] = data[std::min(base + i, rects.count - 1)];
+                }
+                return Float4::Load(lanes);
+            };
+
+            std::array<Float4, 4> cornerX, cornerY;
+            for (int i = 0; i < 4; i++)
+            {
+                cornerX[i] = Load(rects.cornerX[i]) / ellipseScaleX;
+                cornerY[i] = Load(rects.cornerY[i]) / ellipseScaleY;
+            }
+
+            Float4 bestT = infinity;
+            Float4 contactX = zero, contactY = zero;
+            Float4 normalX = zero, normalY = zero;
+
+            // Strict comparison against the running best keeps the first of equal hits, like the scalar loop
+            auto Accept = [&](Mask4 mask, Float4 t, Float4 cx, Float4 cy, Float4 nx, Float4 ny)
+            {
+                bestT = Simd::Select(mask, t, bestT);
+                contactX = Simd::Select(mask, cx, contactX);
+                contactY = Simd::Select(mask, cy, contactY);
+                normalX = Simd::Select(mask, nx, normalX);
+                normalY = Simd::Select(mask, ny, normalY);
+            };
+
+            for (int i = 0; i < 4; i++)
+            {
+                Float4 kx = cornerX[i];
+                Float4 ky = cornerY[i];
+
+                // CirclePointCollision()
+                {
+                    Float4 dx = px - kx;
+                    Float4 dy = py - ky;
+                    Float4 b = two * vx * dx + two * vy * dy;
+                    Float4 c = dx * dx + dy * dy - one;
+                    Float4 discriminant = b * b - four * pointA * c;
+                    Mask4 solvable = discriminant >= zero;
+                    Float4 sqrtDiscriminant = Simd::Sqrt(Simd::Select(solvable, discriminant, zero));
+
+                    Float4 solutions[2] = {
+                        (-b + sqrtDiscriminant) * pointInvTwoA,
+                        (-b - sqrtDiscriminant) * pointInvTwoA
+                    };
+                    for (Float4 t : solutions)
+                    {
+                        Mask4 hit = solvable & (t >= zero) & (t <= one) & (t < bestT);
+                        Accept(hit, t, kx, ky, px + vx * t - kx, py + vy * t - ky);
+                    }
+                }
+
+                // CircleLineCollision() from this corner to the next
+                {
+                    Float4 edgeX = cornerX[(i + 1) % 4] - kx;
+                    Float4 edgeY = cornerY[(i + 1) % 4] - ky;
+                    Float4 baseToVertexX = kx - px;
+                    Float4 baseToVertexY = ky - py;
+
+                    Float4 edgeLengthSq = edgeX * edgeX + edgeY * edgeY;
+                    Float4 edgeDotVelocity = edgeX * vx + edgeY * vy;
+                    Float4 edgeDotBaseToVertex = edgeX * baseToVertexX + edgeY * baseToVertexY;
+                    Float4 baseToVertexLengthSq = baseToVertexX * baseToVertexX + baseToVertexY * baseToVertexY;
+
+                    Float4 a = edgeLengthSq * negVelocityLengthSq + edgeDotVelocity * edgeDotVelocity;
+                    Float4 b = edgeLengthSq * two * (vx * baseToVertexX + vy * baseToVertexY) - two * edgeDotVelocity * edgeDotBaseToVertex;
+                    Float4 c = edgeLengthSq * (one - baseToVertexLengthSq) + edgeDotBaseToVertex * edgeDotBaseToVertex;
+
+                    Float4 discriminant = b * b - four * a * c;
+                    Mask4 solvable = discriminant >= zero;
+                    Float4 sqrtDiscriminant = Simd::Sqrt(Simd::Select(solvable, discriminant, zero));
+                    Float4 invTwoA = one / (two * a);
+
+                    Float4 solutions[2] = {
+                        (-b + sqrtDiscriminant) * invTwoA,
+                        (-b - sqrtDiscriminant) * invTwoA
+                    };
+                    for (Float4 t : solutions)
+                    {
+                        Float4 f = (edgeDotVelocity * t - edgeDotBaseToVertex) / edgeLengthSq;
+                        Mask4 hit = solvable & (t >= zero) & (t <= one) & (f >= zero) & (f <= one) & (t < bestT);
+
+                        Float4 intersectionX = kx + f * edgeX;
+                        Float4 intersectionY = ky + f * edgeY;
+                        Accept(hit, t, intersectionX, intersectionY, px - intersectionX, py - intersectionY);
+                    }
+                }
+            }
+
+            float lanes[5][4];
+            bestT.Store(lanes[0]);
+            contactX.Store(lanes[1]);
+            contactY.Store(lanes[2]);
+            normalX.Store(lanes[3]);
+            normalY.Store(lanes[4]);
+            for (size_t lane = 0; lane < 4 && base + lane < rects.count; lane++)
+            {
+                if (lanes[0][lane] < minCollision.t)
+                {
+                    minCollision.collided = true;
+                    minCollision.t = lanes[0][lane];
+                    minCollision.contactPoint = Math::float2(lanes[1][lane], lanes[2][lane]);
+                    bestNormal = Math::float2(lanes[3][lane], lanes[4][lane]);
+                    if (hitIndex != nullptr)
+                    {
+                        *hitIndex = base + lane;
+                    }
+                }
+            }
+        }
+
+        if (!minCollision.collided)
+        {
+            return { .collided = false };
+        }
+        minCollision.contactPoint *= ellipse.scale;
+        minCollision.normal = Math::Normalize(Math::Normalize(bestNormal) / ellipse.scale);
+        return minCollision;
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "math.hpp"
+#include "transform.hpp"
+
+struct Entity;
+
+namespace Physics
+{
+    struct CollisionData
+    {
+        bool collided = false;
+        Math::float2 contactPoint = 0.0f;
+        Math::float2 normal = 0.0f;
+        float t = 0.0f;
+        const Entity* entity = nullptr;
+    };
+
+    struct Line
+    {
+        Math::float2 from = 0.0f;
+        Math::float2 to = 0.0f;
+    };
+
+    /*
+        World space geometry of an entity, derived from its transform once rather than on every query:
+        - Scene keeps one per entity and rebuilds it in Scene::SetTransform(), which every transform change goes through
+        - Corners follow the order EllipseRectCollision() sweeps them in, and only mean something for rectangles
+        - The transform it was built from is kept, so stale geometry can be caught in debug builds
+    */
+    struct ColliderGeometry
+    {
+        Transform transform;
+        Math::Complex rotation = Math::Complex(1.0f, 0.0f);
+        Math::Complex inverseRotation = Math::Complex(1.0f, 0.0f);
+        std::array<Math::float2, 4> corners{};
+        Math::AABB bounds{};
+        // Gravity direction inside a rectangular gravity zone
+        Math::float2 downDirection = 0.0f;
+
+        static ColliderGeometry FromTransform(const Transform& transform);
+
+        bool IsBuiltFrom(const Transform& transform) const;
+    };
+
+    /*
+        Rectangle corners laid out as structure of arrays for EllipseRectCollisionBatch():
+        - Each array holds one component of one corner of every rectangle, so four rectangles load into one SIMD register
+        - Filled from ColliderGeometry, so building a batch doesn't evaluate any trigonometry
+    */
+    struct RectBatch
+    {
+        static constexpr size_t Capacity = 64;
+
+        float cornerX[4][Capacity];
+        float cornerY[4][Capacity];
+
+        size_t count = 0;
+
+        void Push(const ColliderGeometry& rect);
+
+        inline bool IsFull() const
+        {
+            return count == Capacity;
+        }
+
+        inline void Clear()
+        {
+            count = 0;
+        }
+    };
+
+    CollisionData CirclePointCollision(Math::float2 circlePosition, Math::float2 velocity, Math::float2 point);
+    CollisionData CircleLineCollision(Math::float2 circlePosition, Math::float2 velocity, const Line& line);
+    CollisionData EllipseRectCollision(Transform ellipse, Math::float2 velocity, const ColliderGeometry& rect);
+    CollisionData EllipseRectCollision(const Transform& ellipse, Math::float2 velocity, const Transform& rect);
+    CollisionData CircleCircleCollision(const Transform& circle, Math::float2 velocity, const Transform& other);
+
+    // CircleCircleCollision() treats ellipses as circles of radius scale.x whatever scale.y is, so these bounds cover both shapes
+    Math::AABB GetEllipseBounds(const Transform& ellipse);
+
+    // Same result as calling EllipseRectCollision() on every rectangle and keeping the first closest hit, whose index goes in hitIndex
+    CollisionData EllipseRectCollisionBatch(const Transform& ellipse, Math::float2 velocity, const RectBatch& rects, size_t* hitIndex = nullptr);
+}
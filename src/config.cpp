@@ -1,13 +1,15 @@
 #include "config.hpp"
-#include "application.hpp"
+#include "memory-arena.hpp"
 #include "log.hpp"
 #include "utility.hpp"
 
+#include <memory>
 #include <type_traits>
 #include <variant>
 #include <unordered_map>
 #include <unordered_set>
 #include <stack>
+#include <utility>
 
 namespace Config
 {
@@ -339,9 +341,15 @@ namespace Config
         class Table
         {
         public:
-            Table() = default;
+            Table()
+            {
+                m_ValueMap.arena = s_MemoryArena;
+            }
             Table(StringView filepath, StringView source)
-                : filepath(filepath), source(source) {}
+                : filepath(filepath), source(source)
+            {
+                m_ValueMap.arena = s_MemoryArena;
+            }
 
             Table(const Table&) = delete;
             Table& operator=(const Table&) = delete;
@@ -353,14 +361,14 @@ namespace Config
             template<typename T>
             T* Get(StringView key)
             {
-                auto it = m_ValueMap.find(key);
-                if (it == m_ValueMap.end())
+                ValueType* value = m_ValueMap.Find(key);
+                if (value == nullptr)
                 {
                     return nullptr;
                 }
-                if (std::holds_alternative<T>(it->second))
+                if (std::holds_alternative<T>(*value))
                 {
-                    return &std::get<T>(it->second);
+                    return &std::get<T>(*value);
                 }
                 return nullptr;
             }
@@ -390,7 +398,7 @@ namespace Config
             [[nodiscard]]
             bool Has(StringView key)
             {
-                return m_ValueMap.find(key) != m_ValueMap.end();
+                return m_ValueMap.Contains(key);
             }
 
             using ValueType = std::variant<
@@ -400,7 +408,7 @@ namespace Config
                 StringView, Array<StringView>
             >;
 
-            std::unordered_map<StringView, ValueType> m_ValueMap;
+            HashMap<StringView, ValueType> m_ValueMap;
 
             friend class TableView;
         };
@@ -483,9 +491,11 @@ namespace Config
                 return TableView(m_Table, newPrefix);
             }
 
+            // The concatenated key is only needed for the lookup, so it is rewound right after
             [[nodiscard]]
             bool Has(StringView key)
             {
+                ArenaTemp scratch(s_MemoryArena);
                 return m_Table->Has(GetKey(key));
             }
 
@@ -493,6 +503,7 @@ namespace Config
             [[nodiscard]]
             T* Get(StringView key)
             {
+                ArenaTemp scratch(s_MemoryArena);
                 return m_Table->Get<T>(GetKey(key));
             }
 
@@ -500,6 +511,7 @@ namespace Config
             [[nodiscard]]
             bool Get(StringView key, std::array<T, Count>& array)
             {
+                ArenaTemp scratch(s_MemoryArena);
                 return m_Table->Get<T, Count>(GetKey(key), array);
             }
 
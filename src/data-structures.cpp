@@ -192,6 +192,58 @@ String String::Copy(StringView str, MemoryArena* arena)
     return out;
 }
 
+void SmallString::Reserve(size_t newCapacity)
+{
+    size_t currentCapacity = capacity == 0 ? InlineCapacity : capacity;
+    if (newCapacity <= currentCapacity)
+    {
+        return;
+    }
+    assert(pool != nullptr && "SmallString needs a pool to grow beyond its inline capacity");
+
+    newCapacity = std::bit_ceil(newCapacity);
+    if (capacity == 0)
+    {
+        char* newData = (char*)pool->Alloc(newCapacity, 1);
+        memcpy(newData, inlineData, size);
+        heapData = newData;
+    }
+    else
+    {
+        heapData = (char*)pool->Realloc(heapData, capacity, newCapacity, 1);
+    }
+    capacity = newCapacity;
+}
+
+void SmallString::Append(StringView str)
+{
+    Reserve(size + str.size);
+    memcpy(Data() + size, str.data, str.size);
+    size += str.size;
+}
+
+void SmallString::Clear()
+{
+    memset(Data(), 0, size);
+    size = 0;
+}
+
+void SmallString::Free()
+{
+    if (capacity != 0)
+    {
+        pool->Free(heapData, capacity);
+    }
+    capacity = 0;
+    size = 0;
+    memset(inlineData, 0, InlineCapacity);
+}
+
+bool SmallString::operator==(StringView str) const
+{
+    return StringView(*this).Equals(str);
+}
+
 StringView::StringView(const String& str)
 {
     data = str.data;
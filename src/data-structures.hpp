@@ -2,10 +2,12 @@
 
 #include <cstddef>
 #include <type_traits>
+#include <concepts>
 #include <cassert>
 #include <cstring>
 #include <bit>
 #include <string_view>
+#include <new>
 
 #include "memory-arena.hpp"
 #include "math.hpp"
@@ -41,17 +43,29 @@ struct Array
 
     MemoryArena* arena = nullptr;
 
+    // If set, memory comes from the pool instead of the arena and can be given back with Free()
+    // NOTE: Copies of the array share its memory, so only one of them may call Free()
+    MemoryPool* pool = nullptr;
+
     T* data = nullptr;
     size_t size = 0;
     size_t capacity = 0;
 
     inline void Reserve(size_t newCapacity)
     {
-        assert(arena != nullptr);
+        assert(arena != nullptr || pool != nullptr);
         if (newCapacity <= capacity)
         {
             return;
         }
+        if (pool != nullptr)
+        {
+            data = data == nullptr ?
+                (T*)pool->Alloc(sizeof(T) * newCapacity, alignof(T)) :
+                (T*)pool->Realloc(data, sizeof(T) * capacity, sizeof(T) * newCapacity, alignof(T));
+            capacity = newCapacity;
+            return;
+        }
         if (data == nullptr)
         {
             data = arena->Alloc<T>(newCapacity);
@@ -67,7 +81,18 @@ struct Array
         if (newSize == size) return;
         if (newSize < size)
         {
-            memset(data + newSize, 0, (size - newSize) * sizeof(T));
+            if constexpr (std::is_trivial_v<T>)
+            {
+                memset(data + newSize, 0, (size - newSize) * sizeof(T));
+            }
+            else
+            {
+                // Types with default member initializers can't be memset without a -Wclass-memaccess warning
+                for (size_t i = newSize; i < size; i++)
+                {
+                    data[i] = T{};
+                }
+            }
             size = newSize;
             return;
         }
@@ -96,12 +121,30 @@ struct Array
         data[size] = 0;
     }
 
+    // Gives the memory back to the pool. Arena memory is only reclaimed when the arena is cleared
+    inline void Free()
+    {
+        if (pool != nullptr && data != nullptr)
+        {
+            pool->Free(data, sizeof(T) * capacity);
+        }
+        data = nullptr;
+        size = 0;
+        capacity = 0;
+    }
+
     inline T& operator[](size_t index)
     {
         assert(index >= 0 && index < size);
         return data[index];
     }
 
+    inline const T& operator[](size_t index) const
+    {
+        assert(index >= 0 && index < size);
+        return data[index];
+    }
+
     PointerIterator<T> begin()
     {
         return { .ptr = data };
@@ -304,6 +347,201 @@ struct StableArray
     };
 };
 
+/*
+    A StableArray that finds free slots and blocks without walking a linked list:
+    - Blocks are kept in a directory, and a summary bitmap has one bit per block that still has a free slot
+    - Push() finds a free slot with a countr_zero() on the summary and a countr_one() on the block
+    - Erase(ptr) finds the block of ptr with a binary search over the blocks sorted by address
+    - Iteration walks the directory in the order the blocks were allocated
+    - Pointers stay valid until the element is erased or the array is cleared
+*/
+
+template<typename T>
+struct IndexedStableArray
+{
+    static_assert(std::is_trivially_destructible_v<T>);
+
+    constexpr static size_t BlockSize = 64;
+
+    MemoryArena* arena = nullptr;
+
+    Array<T*> blocks;
+    Array<uint64_t> allocatedMasks;
+    Array<uint64_t> nonFullMasks;
+
+    // Indices into blocks, sorted by the address of the block
+    Array<uint32_t> sortedBlocks;
+
+    // Every summary word before this one is known to be zero
+    size_t firstNonFullWord = 0;
+
+    size_t size = 0;
+
+    inline T* Push(T value)
+    {
+        size_t word = firstNonFullWord;
+        while (word < nonFullMasks.size && nonFullMasks[word] == 0)
+        {
+            word++;
+        }
+        firstNonFullWord = word;
+        if (word == nonFullMasks.size)
+        {
+            AddBlock();
+            word = (blocks.size - 1) / 64;
+            firstNonFullWord = word;
+        }
+
+        int summaryBit = std::countr_zero(nonFullMasks[word]);
+        size_t blockIndex = word * 64 + summaryBit;
+
+        uint64_t& mask = allocatedMasks[blockIndex];
+        int slot = std::countr_one(mask);
+        mask |= (uint64_t)1 << slot;
+        if (mask == ~(uint64_t)0)
+        {
+            nonFullMasks[word] &= ~((uint64_t)1 << summaryBit);
+        }
+
+        T* result = blocks[blockIndex] + slot;
+        *result = value;
+        size++;
+        return result;
+    }
+
+    inline void Erase(T* ptr)
+    {
+        size_t blockIndex = FindBlock(ptr);
+        size_t slot = ptr - blocks[blockIndex];
+        assert(allocatedMasks[blockIndex] & ((uint64_t)1 << slot));
+
+        allocatedMasks[blockIndex] &= ~((uint64_t)1 << slot);
+        nonFullMasks[blockIndex / 64] |= (uint64_t)1 << (blockIndex % 64);
+        firstNonFullWord = Math::Min(firstNonFullWord, blockIndex / 64);
+        size--;
+    }
+
+    // Keeps the blocks around so they can be reused
+    inline void Clear()
+    {
+        for (size_t i = 0; i < allocatedMasks.size; i++)
+        {
+            allocatedMasks[i] = 0;
+        }
+        for (size_t i = 0; i < nonFullMasks.size; i++)
+        {
+            size_t numBlocks = Math::Min(blocks.size - i * 64, (size_t)64);
+            nonFullMasks[i] = numBlocks == 64 ? ~(uint64_t)0 : ((uint64_t)1 << numBlocks) - 1;
+        }
+        firstNonFullWord = 0;
+        size = 0;
+    }
+
+    struct Iterator
+    {
+        const IndexedStableArray<T>* array = nullptr;
+        size_t blockIndex = 0;
+        uint64_t currentMask = 0;
+
+        inline T& operator*() const
+        {
+            assert(array != nullptr && currentMask != 0);
+            return array->blocks[blockIndex][std::countr_zero(currentMask)];
+        }
+        inline T& operator++()
+        {
+            assert(array != nullptr && currentMask != 0);
+            int next = std::countr_zero(currentMask);
+            currentMask &= ~((uint64_t)1 << next);
+            T* result = &array->blocks[blockIndex][next];
+            NextNonEmpty();
+            return *result;
+        }
+        inline bool operator==(Iterator other)
+        {
+            return array == other.array && blockIndex == other.blockIndex && currentMask == other.currentMask;
+        };
+        inline void NextNonEmpty()
+        {
+            while (currentMask == 0)
+            {
+                blockIndex++;
+                if (blockIndex >= array->blocks.size)
+                {
+                    *this = {};
+                    break;
+                }
+                currentMask = array->allocatedMasks[blockIndex];
+            }
+        }
+    };
+    inline Iterator begin() const
+    {
+        if (blocks.size == 0)
+        {
+            return {};
+        }
+        Iterator iterator { .array = this, .blockIndex = 0, .currentMask = allocatedMasks[0] };
+        iterator.NextNonEmpty();
+        return iterator;
+    };
+    inline Iterator end() const
+    {
+        return {};
+    };
+
+private:
+    inline void AddBlock()
+    {
+        assert(arena != nullptr && (arena->flags & MemoryArenaFlags_ClearToZero));
+        blocks.arena = arena;
+        allocatedMasks.arena = arena;
+        nonFullMasks.arena = arena;
+        sortedBlocks.arena = arena;
+
+        T* block = arena->Alloc<T>(BlockSize);
+        uint32_t blockIndex = blocks.size;
+        blocks.Push(block);
+        allocatedMasks.Push(0);
+        if (blockIndex % 64 == 0)
+        {
+            nonFullMasks.Push(0);
+        }
+        nonFullMasks[blockIndex / 64] |= (uint64_t)1 << (blockIndex % 64);
+
+        // Insertion sort, blocks are rare compared to elements
+        sortedBlocks.Push(blockIndex);
+        for (size_t i = sortedBlocks.size - 1; i > 0 && blocks[sortedBlocks[i - 1]] > block; i--)
+        {
+            sortedBlocks[i] = sortedBlocks[i - 1];
+            sortedBlocks[i - 1] = blockIndex;
+        }
+    }
+
+    inline size_t FindBlock(const T* ptr) const
+    {
+        // Find the last block that starts at or before ptr
+        size_t low = 0;
+        size_t high = sortedBlocks.size;
+        while (low < high)
+        {
+            size_t middle = (low + high) / 2;
+            if (blocks[sortedBlocks[middle]] <= ptr)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+        assert(low > 0);
+        size_t blockIndex = sortedBlocks[low - 1];
+        assert(ptr < blocks[blockIndex] + BlockSize);
+        return blockIndex;
+    }
+};
+
 inline constexpr size_t GetCStringLength(const char* str)
 {
     if (std::is_constant_evaluated())
@@ -459,12 +697,511 @@ struct StringView
     }
 };
 
-// TODO: Remove reliance on std::string_view
+/*
+    A string that keeps up to InlineCapacity characters inside the struct itself:
+    - Longer strings spill to a block from the pool, which Free() gives back
+    - Use Data() rather than holding on to a pointer, since the characters move with the struct while inline
+    - The characters are not null terminated
+*/
+
+struct SmallString
+{
+    static constexpr size_t InlineCapacity = 24;
+
+    MemoryPool* pool = nullptr;
+
+    uint32_t size = 0;
+
+    // Zero while the characters are stored inline
+    uint32_t capacity = 0;
+
+    union
+    {
+        char inlineData[InlineCapacity] = {};
+        char* heapData;
+    };
+
+    inline char* Data()
+    {
+        return capacity == 0 ? inlineData : heapData;
+    }
+    inline const char* Data() const
+    {
+        return capacity == 0 ? inlineData : heapData;
+    }
+
+    inline operator StringView() const
+    {
+        return StringView(Data(), size);
+    }
+
+    void Reserve(size_t newCapacity);
+
+    void Append(StringView str);
+
+    template<typename T>
+    inline void operator+=(const T& other)
+    {
+        Append(other);
+    }
+
+    void Clear();
+
+    // Gives spilled memory back to the pool and goes back to inline storage
+    void Free();
+
+    bool operator==(StringView str) const;
+};
+
+// FNV-1a, constexpr so hashes of string literals can be computed at compile time
+inline constexpr uint64_t HashString(StringView str)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    for (size_t i = 0; i < str.size; i++)
+    {
+        hash ^= (uint8_t)str.data[i];
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+// Finalizer from SplitMix64, spreads integers and pointers across all bits
+inline constexpr uint64_t HashInteger(uint64_t value)
+{
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111eb;
+    value ^= value >> 31;
+    return value;
+}
+
+template<typename T>
+inline constexpr uint64_t Hash(const T& value)
+{
+    if constexpr (std::is_integral_v<T> || std::is_enum_v<T>)
+    {
+        return HashInteger((uint64_t)value);
+    }
+    else if constexpr (std::is_pointer_v<T>)
+    {
+        return HashInteger((uint64_t)(uintptr_t)value);
+    }
+    else if constexpr (requires { { value.GetHash() } -> std::convertible_to<uint64_t>; })
+    {
+        return value.GetHash();
+    }
+    else
+    {
+        return HashString(StringView(value));
+    }
+}
+
 template<>
 struct std::hash<StringView>
 {
     size_t operator()(const StringView& view) const
     {
-        return std::hash<std::string_view>{}(std::string_view(view.data, view.size));
+        return HashString(view);
+    }
+};
+
+/*
+    An open addressing hash map using Robin Hood hashing:
+    - Entries are stored in one flat array allocated from the arena, so a lookup touches a couple of cache lines
+    - Each slot stores its distance from the slot its key hashes to, and inserts displace entries that are closer to home
+    - Erase() shifts the following entries back instead of leaving tombstones
+    - Pointers to values are invalidated when the map grows or an entry is erased
+    - Old entry arrays are only reclaimed when the arena is cleared
+*/
+
+template<typename K, typename V>
+struct HashMap
+{
+    static_assert(std::is_trivially_destructible_v<K> && std::is_trivially_destructible_v<V>);
+
+    struct Entry
+    {
+        K key;
+        V value;
+    };
+
+    static constexpr size_t MinCapacity = 16;
+
+    MemoryArena* arena = nullptr;
+
+    Entry* entries = nullptr;
+
+    // Distance from the slot the key hashes to plus one, zero for empty slots
+    uint8_t* distances = nullptr;
+
+    size_t capacity = 0;
+    size_t size = 0;
+
+    inline V* Find(const K& key) const
+    {
+        size_t index = FindIndex(key);
+        return index != NotFound ? &entries[index].value : nullptr;
+    }
+
+    inline bool Contains(const K& key) const
+    {
+        return Find(key) != nullptr;
+    }
+
+    // Overwrites the value if the key already exists
+    inline V* Insert(const K& key, const V& value)
+    {
+        V* existing = Find(key);
+        if (existing != nullptr)
+        {
+            *existing = value;
+            return existing;
+        }
+        return InsertNew(key, value);
+    }
+
+    // Inserts a default constructed value if the key doesn't exist
+    inline V& operator[](const K& key)
+    {
+        V* existing = Find(key);
+        if (existing != nullptr)
+        {
+            return *existing;
+        }
+        return *InsertNew(key, V{});
+    }
+
+    inline bool Erase(const K& key)
+    {
+        size_t index = FindIndex(key);
+        if (index == NotFound)
+        {
+            return false;
+        }
+        size_t mask = capacity - 1;
+
+        // Shift the following entries back until one is empty or already in its home slot
+        size_t next = (index + 1) & mask;
+        while (distances[next] > 1)
+        {
+            entries[index] = entries[next];
+            distances[index] = distances[next] - 1;
+            index = next;
+            next = (next + 1) & mask;
+        }
+        distances[index] = 0;
+        size--;
+        return true;
+    }
+
+    inline void Clear()
+    {
+        if (distances != nullptr)
+        {
+            memset(distances, 0, capacity);
+        }
+        size = 0;
+    }
+
+    inline void Reserve(size_t count)
+    {
+        // Keep the load factor below 7/8
+        size_t newCapacity = std::bit_ceil(Math::Max(count + count / 7 + 1, MinCapacity));
+        if (newCapacity > capacity)
+        {
+            Rehash(newCapacity);
+        }
+    }
+
+    struct Iterator
+    {
+        const HashMap<K, V>* map = nullptr;
+        size_t index = 0;
+
+        inline Entry& operator*() const
+        {
+            return map->entries[index];
+        }
+        inline Iterator& operator++()
+        {
+            index++;
+            NextOccupied();
+            return *this;
+        }
+        inline bool operator==(Iterator other) const
+        {
+            return index == other.index;
+        }
+        inline void NextOccupied()
+        {
+            while (index < map->capacity && map->distances[index] == 0)
+            {
+                index++;
+            }
+        }
+    };
+    inline Iterator begin() const
+    {
+        Iterator iterator { .map = this, .index = 0 };
+        iterator.NextOccupied();
+        return iterator;
+    }
+    inline Iterator end() const
+    {
+        return { .map = this, .index = capacity };
+    }
+
+private:
+    static constexpr size_t NotFound = SIZE_MAX;
+
+    inline size_t FindIndex(const K& key) const
+    {
+        if (size == 0)
+        {
+            return NotFound;
+        }
+        size_t mask = capacity - 1;
+        size_t index = Hash(key) & mask;
+
+        // Once a slot is closer to its home than the key would be, the key can't be further along
+        for (uint32_t distance = 1; distance <= distances[index]; distance++)
+        {
+            if (distances[index] == distance && entries[index].key == key)
+            {
+                return index;
+            }
+            index = (index + 1) & mask;
+        }
+        return NotFound;
+    }
+
+    inline V* InsertNew(K key, V value)
+    {
+        const K insertedKey = key;
+
+        if ((size + 1) * 8 > capacity * 7)
+        {
+            Rehash(Math::Max(capacity * 2, MinCapacity));
+        }
+
+        size_t mask = capacity - 1;
+        size_t index = Hash(key) & mask;
+        uint32_t distance = 1;
+        V* result = nullptr;
+        while (true)
+        {
+            if (distances[index] == 0)
+            {
+                new (&entries[index]) Entry{ key, value };
+                distances[index] = distance;
+                size++;
+                return result != nullptr ? result : &entries[index].value;
+            }
+            if (distances[index] < distance)
+            {
+                // Take the slot from an entry that is closer to its home, and carry on inserting that one
+                Entry displaced = entries[index];
+                uint32_t displacedDistance = distances[index];
+                entries[index] = Entry{ key, value };
+                distances[index] = distance;
+                if (result == nullptr)
+                {
+                    result = &entries[index].value;
+                }
+                key = displaced.key;
+                value = displaced.value;
+                distance = displacedDistance;
+            }
+            index = (index + 1) & mask;
+            distance++;
+
+            if (distance == UINT8_MAX)
+            {
+                // Pathological clustering, grow and start over with whatever entry is being carried
+                Rehash(capacity * 2);
+                InsertNew(key, value);
+                return Find(insertedKey);
+            }
+        }
+    }
+
+    inline void Rehash(size_t newCapacity)
+    {
+        assert(arena != nullptr && std::has_single_bit(newCapacity));
+
+        Entry* oldEntries = entries;
+        uint8_t* oldDistances = distances;
+        size_t oldCapacity = capacity;
+
+        entries = (Entry*)arena->Alloc(sizeof(Entry) * newCapacity, alignof(Entry));
+        distances = (uint8_t*)arena->Alloc(newCapacity, 1);
+        memset(distances, 0, newCapacity);
+        capacity = newCapacity;
+        size = 0;
+
+        for (size_t i = 0; i < oldCapacity; i++)
+        {
+            if (oldDistances[i] != 0)
+            {
+                InsertNew(oldEntries[i].key, oldEntries[i].value);
+            }
+        }
+    }
+};
+
+/*
+    A 32-bit reference to an object in a HandleTable:
+    - The low IndexBits bits are the slot index, which is dense, so it can index per-object side arrays directly
+    - The remaining bits are the generation of the slot, which changes every time the slot is freed
+    - A handle whose generation no longer matches its slot is stale and resolves to nullptr
+    - Generation zero is never handed out, so a zero handle is always null
+*/
+
+template<typename T>
+struct Handle
+{
+    static constexpr uint32_t IndexBits = 20;
+    static constexpr uint32_t IndexMask = (1u << IndexBits) - 1;
+    static constexpr uint32_t GenerationMask = (1u << (32 - IndexBits)) - 1;
+
+    uint32_t value = 0;
+
+    constexpr Handle() = default;
+    constexpr Handle(uint32_t index, uint32_t generation)
+        : value(index | (generation << IndexBits))
+    {
+        assert(index <= IndexMask && generation <= GenerationMask);
+    }
+
+    constexpr uint32_t GetIndex() const
+    {
+        return value & IndexMask;
+    }
+    constexpr uint32_t GetGeneration() const
+    {
+        return value >> IndexBits;
+    }
+
+    constexpr bool IsNull() const
+    {
+        return value == 0;
+    }
+
+    constexpr uint64_t GetHash() const
+    {
+        return HashInteger(value);
+    }
+
+    constexpr bool operator==(const Handle& other) const = default;
+};
+
+/*
+    Maps handles to pointers in O(1):
+    - Every slot stores the pointer and its current generation
+    - Freed slots are reused most recently freed first, with their generation bumped
+    - Reset() frees every slot at once but keeps their generations, so no handle from before it resolves afterwards
+*/
+
+template<typename T>
+struct HandleTable
+{
+    MemoryArena* arena = nullptr;
+
+    struct Slot
+    {
+        T* ptr = nullptr;
+        uint32_t generation = 0;
+    };
+    Array<Slot> slots;
+    Array<uint32_t> freeSlots;
+
+    size_t size = 0;
+
+    inline Handle<T> Create(T* ptr)
+    {
+        assert(ptr != nullptr);
+
+        uint32_t index;
+        if (freeSlots.size > 0)
+        {
+            index = freeSlots[freeSlots.size - 1];
+            freeSlots.Pop();
+        }
+        else
+        {
+            assert(slots.size <= Handle<T>::IndexMask && "Out of handle slots");
+            index = slots.size;
+            slots.arena = arena;
+            slots.Push(Slot{ .ptr = nullptr, .generation = 1 });
+        }
+
+        slots[index].ptr = ptr;
+        size++;
+        return Handle<T>(index, slots[index].generation);
+    }
+
+    inline void Destroy(Handle<T> handle)
+    {
+        assert(Get(handle) != nullptr);
+
+        Slot& slot = slots[handle.GetIndex()];
+        slot.ptr = nullptr;
+        slot.generation = NextGeneration(slot.generation);
+
+        freeSlots.arena = arena;
+        freeSlots.Push(handle.GetIndex());
+        size--;
+    }
+
+    // Returns nullptr for null and stale handles
+    inline T* Get(Handle<T> handle) const
+    {
+        uint32_t index = handle.GetIndex();
+        if (index >= slots.size)
+        {
+            return nullptr;
+        }
+        const Slot& slot = slots[index];
+        return slot.generation == handle.GetGeneration() ? slot.ptr : nullptr;
+    }
+
+    // For walking side arrays by index, returns nullptr for free slots
+    inline T* GetAtIndex(uint32_t index) const
+    {
+        return index < slots.size ? slots[index].ptr : nullptr;
+    }
+
+    // One past the highest index handed out so far, the size needed for a side array indexed by handles
+    inline size_t GetIndexCount() const
+    {
+        return slots.size;
+    }
+
+    // The generations live in the slots, so the arena behind the table must not be cleared before this
+    inline void Reset()
+    {
+        freeSlots.arena = arena;
+        freeSlots.Resize(0);
+        freeSlots.Reserve(slots.size + 1);
+        // Pushed in reverse, so the lowest indices are handed out first like in a fresh table
+        for (uint32_t index = slots.size; index-- > 0;)
+        {
+            Slot& slot = slots[index];
+            if (slot.ptr != nullptr)
+            {
+                slot.ptr = nullptr;
+                slot.generation = NextGeneration(slot.generation);
+            }
+            freeSlots.Push(index);
+        }
+        size = 0;
+    }
+
+private:
+    static constexpr uint32_t NextGeneration(uint32_t generation)
+    {
+        generation = (generation + 1) & Handle<T>::GenerationMask;
+        return generation == 0 ? 1 : generation;
     }
 };
@@ -209,6 +209,7 @@ bool FontAtlas::Init(Renderer& renderer, int width, int height)
 bool FontAtlas::LoadFont(wgpu::Queue queue, StringView path, const Charset& charset, float fontSize)
 {
     m_FontSize = fontSize;
+    m_GlyphMap.arena = &GlobalArena;
 
     Span<uint8_t> fontBuffer = ReadFileBuffer(path, &TransientArena);
 
@@ -253,7 +254,7 @@ bool FontAtlas::LoadFont(wgpu::Queue queue, StringView path, const Charset& char
             .offset = { (float)offsetX, (float)offsetY },
             .size = { (float)rect.w, (float)rect.h }
         };
-        m_GlyphMap.insert({ c, glyph });
+        m_GlyphMap.Insert(c, glyph);
 
         sdfs[i] = data;
     }
@@ -292,9 +293,9 @@ bool FontAtlas::LoadFont(wgpu::Queue queue, StringView path, const Charset& char
             }
         }
 
-        auto it = m_GlyphMap.find(c);
-        assert(it != m_GlyphMap.end());
-        Glyph& glyph = it->second;
+        Glyph* glyphPtr = m_GlyphMap.Find(c);
+        assert(glyphPtr != nullptr);
+        Glyph& glyph = *glyphPtr;
 
         glyph.texPosition = Math::float2{ (float)rect.x, (float)rect.y } / textureSize;
         glyph.texSize = Math::float2{ (float)rect.w, (float)rect.h } / textureSize;
@@ -392,7 +393,9 @@ void FontAtlas::RenderText(wgpu::Queue queue, wgpu::RenderPassEncoder renderEnco
     {
         // Not enough space in m_QuadBuffer
         constexpr size_t maxCharCount = s_QuadBufferSize / sizeof(GlyphQuad);
-        Log::Error("Font atlas RenderText() character limit reached (Max % characters).", maxCharCount);
+        // Hit every frame while there is too much text on screen
+        static Log::RateLimit rateLimit(1);
+        Log::Error(rateLimit, "Font atlas RenderText() character limit reached (Max % characters).", maxCharCount);
         return;
     }
     size_t offset = m_QuadsWritten * sizeof(GlyphQuad);
@@ -444,11 +447,11 @@ float FontAtlas::GetTextHeight(StringView text) const
 
 const FontAtlas::Glyph& FontAtlas::GetGlyph(char c) const
 {
-    auto it = m_GlyphMap.find(c);
-    if (it == m_GlyphMap.end())
+    const Glyph* glyph = m_GlyphMap.Find(c);
+    if (glyph == nullptr)
     {
-        it = m_GlyphMap.find(s_DefaultChar);
-        assert(it != m_GlyphMap.end());
+        glyph = m_GlyphMap.Find(s_DefaultChar);
+        assert(glyph != nullptr);
     }
-    return it->second;
+    return *glyph;
 }
@@ -88,7 +88,7 @@ private:
     };
 
     static constexpr char s_DefaultChar = '?';
-    std::unordered_map<char, Glyph> m_GlyphMap;
+    HashMap<char, Glyph> m_GlyphMap;
 
     float GetTextWidth(StringView text) const;
     float GetTextHeight(StringView text) const;
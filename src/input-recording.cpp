@@ -0,0 +1,351 @@
+#include "input-recording.hpp"
+
+#include <cassert>
+#include <cstring>
+
+#include "log.hpp"
+
+namespace InputRecording
+{
+    static uint8_t* WriteVarint(uint8_t* out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            *out++ = (uint8_t)(value | 0x80);
+            value >>= 7;
+        }
+        *out++ = (uint8_t)value;
+        return out;
+    }
+
+    // Writes the positions of the bits that differ between the two sets
+    static uint8_t* WriteFlippedKeys(uint8_t* out, const std::bitset<SDL_SCANCODE_COUNT>& previous, const std::bitset<SDL_SCANCODE_COUNT>& current)
+    {
+        std::bitset<SDL_SCANCODE_COUNT> flipped = previous ^ current;
+        out = WriteVarint(out, flipped.count());
+        size_t last = 0;
+        for (size_t scancode = 0; scancode < flipped.size(); scancode++)
+        {
+            if (flipped[scancode])
+            {
+                out = WriteVarint(out, scancode - last);
+                last = scancode;
+            }
+        }
+        return out;
+    }
+
+    static bool HasChange(uint8_t changes, Change change)
+    {
+        return changes & (uint8_t)change;
+    }
+
+    bool Recorder::Start(const char* filePath, uint32_t startState)
+    {
+        assert(!IsActive() && "Input recording has already started");
+
+        m_File = fopen(filePath, "wb");
+        if (m_File == nullptr)
+        {
+            Log::Error("Failed to open input recording '%'", StringView(filePath));
+            return false;
+        }
+        fwrite(&Magic, sizeof(Magic), 1, m_File);
+        fwrite(&Version, sizeof(Version), 1, m_File);
+        fwrite(&startState, sizeof(startState), 1, m_File);
+
+        m_Previous = Input();
+        m_RecordSize = 0;
+        m_Repeats = 0;
+        m_FrameCount = 0;
+        return true;
+    }
+
+    void Recorder::RecordFrame(const Input& input)
+    {
+        if (!IsActive())
+        {
+            return;
+        }
+
+        uint8_t changes = 0;
+        if (input.m_KeysDown != m_Previous.m_KeysDown)                    changes |= (uint8_t)Change::KeysDown;
+        if (input.m_KeysPressed != m_Previous.m_KeysPressed)              changes |= (uint8_t)Change::KeysPressed;
+        if (input.m_FirstKeyPressed != m_Previous.m_FirstKeyPressed)      changes |= (uint8_t)Change::FirstKeyPressed;
+        if (input.m_MousePosition.x != m_Previous.m_MousePosition.x ||
+            input.m_MousePosition.y != m_Previous.m_MousePosition.y)      changes |= (uint8_t)Change::MousePosition;
+        if (input.m_MouseDownState != m_Previous.m_MouseDownState ||
+            input.m_MousePressedState != m_Previous.m_MousePressedState)  changes |= (uint8_t)Change::MouseButtons;
+        if (input.controls != m_Previous.controls)                        changes |= (uint8_t)Change::Controls;
+
+        m_FrameCount++;
+        if (changes == 0 && m_FrameCount > 1)
+        {
+            m_Repeats++;
+            return;
+        }
+        WriteRecord();
+
+        uint8_t* out = m_Record;
+        *out++ = changes;
+        if (HasChange(changes, Change::KeysDown))
+        {
+            out = WriteFlippedKeys(out, m_Previous.m_KeysDown, input.m_KeysDown);
+        }
+        if (HasChange(changes, Change::KeysPressed))
+        {
+            out = WriteFlippedKeys(out, m_Previous.m_KeysPressed, input.m_KeysPressed);
+        }
+        if (HasChange(changes, Change::FirstKeyPressed))
+        {
+            out = WriteVarint(out, input.m_FirstKeyPressed);
+        }
+        if (HasChange(changes, Change::MousePosition))
+        {
+            memcpy(out, &input.m_MousePosition, sizeof(input.m_MousePosition));
+            out += sizeof(input.m_MousePosition);
+        }
+        if (HasChange(changes, Change::MouseButtons))
+        {
+            *out++ = input.m_MouseDownState;
+            *out++ = input.m_MousePressedState;
+        }
+        if (HasChange(changes, Change::Controls))
+        {
+            for (const auto& scancodes : input.controls)
+            {
+                for (SDL_Scancode scancode : scancodes)
+                {
+                    out = WriteVarint(out, scancode);
+                }
+            }
+        }
+        m_RecordSize = out - m_Record;
+        assert(m_RecordSize <= MaxRecordSize);
+        m_Previous = input;
+    }
+
+    void Recorder::WriteRecord()
+    {
+        if (m_RecordSize == 0)
+        {
+            return;
+        }
+        // The flags byte written first into the record becomes the low bits of the header
+        uint8_t header[10];
+        size_t headerSize = WriteVarint(header, (m_Repeats << ChangeBits) | m_Record[0]) - header;
+        fwrite(header, sizeof(uint8_t), headerSize, m_File);
+        fwrite(m_Record + 1, sizeof(uint8_t), m_RecordSize - 1, m_File);
+        m_RecordSize = 0;
+        m_Repeats = 0;
+    }
+
+    void Recorder::Stop()
+    {
+        if (!IsActive())
+        {
+            return;
+        }
+        WriteRecord();
+        fclose(m_File);
+        m_File = nullptr;
+        Log::Info("Recorded % frames of input", m_FrameCount);
+    }
+
+    bool Recorder::IsActive() const
+    {
+        return m_File != nullptr;
+    }
+
+    uint64_t Recorder::GetFrameCount() const
+    {
+        return m_FrameCount;
+    }
+
+    bool Replay::Load(const char* filePath, MemoryArena* arena)
+    {
+        FILE* file = fopen(filePath, "rb");
+        if (file == nullptr)
+        {
+            Log::Error("Failed to open input recording '%'", StringView(filePath));
+            return false;
+        }
+        fseek(file, 0, SEEK_END);
+        size_t size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        uint8_t* data = arena->Alloc<uint8_t>(size);
+        size = fread(data, sizeof(uint8_t), size, file);
+        fclose(file);
+
+        if (!Load(Span<const uint8_t>(data, size)))
+        {
+            Log::Error("'%' is not an input recording", StringView(filePath));
+            return false;
+        }
+        return true;
+    }
+
+    bool Replay::Load(Span<const uint8_t> data)
+    {
+        uint32_t header[3];
+        if (data.size < sizeof(header))
+        {
+            return false;
+        }
+        memcpy(header, data.data, sizeof(header));
+        if (header[0] != Magic || header[1] != Version)
+        {
+            return false;
+        }
+
+        m_Data = data;
+        m_Offset = sizeof(header);
+        m_Active = true;
+        m_State = Input();
+        m_Repeats = 0;
+        m_StartState = header[2];
+        return true;
+    }
+
+    bool Replay::NextFrame(Input& input)
+    {
+        if (!IsActive())
+        {
+            return false;
+        }
+        if (m_Repeats > 0)
+        {
+            m_Repeats--;
+        }
+        else if (m_Offset == m_Data.size)
+        {
+            Stop();
+            return false;
+        }
+        else if (!ReadRecord())
+        {
+            Log::Error("Input recording is malformed at byte %", m_Offset);
+            Stop();
+            return false;
+        }
+        input = m_State;
+        return true;
+    }
+
+    bool Replay::ReadRecord()
+    {
+        auto ReadVarint = [this](uint64_t& value)
+        {
+            value = 0;
+            for (int shift = 0; shift < 64 && m_Offset < m_Data.size; shift += 7)
+            {
+                uint8_t byte = m_Data[m_Offset++];
+                value |= (uint64_t)(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0)
+                {
+                    return true;
+                }
+            }
+            return false;
+        };
+        auto ReadScancode = [&](SDL_Scancode& scancode)
+        {
+            uint64_t value;
+            if (!ReadVarint(value) || value >= SDL_SCANCODE_COUNT)
+            {
+                return false;
+            }
+            scancode = (SDL_Scancode)value;
+            return true;
+        };
+        auto ReadFlippedKeys = [&](std::bitset<SDL_SCANCODE_COUNT>& keys)
+        {
+            uint64_t count;
+            if (!ReadVarint(count) || count > SDL_SCANCODE_COUNT)
+            {
+                return false;
+            }
+            uint64_t scancode = 0;
+            for (uint64_t i = 0; i < count; i++)
+            {
+                uint64_t distance;
+                if (!ReadVarint(distance) || scancode + distance >= SDL_SCANCODE_COUNT)
+                {
+                    return false;
+                }
+                scancode += distance;
+                keys.flip(scancode);
+            }
+            return true;
+        };
+
+        uint64_t header;
+        if (!ReadVarint(header))
+        {
+            return false;
+        }
+        uint8_t changes = header & ((1 << ChangeBits) - 1);
+        m_Repeats = header >> ChangeBits;
+
+        if (HasChange(changes, Change::KeysDown) && !ReadFlippedKeys(m_State.m_KeysDown))
+        {
+            return false;
+        }
+        if (HasChange(changes, Change::KeysPressed) && !ReadFlippedKeys(m_State.m_KeysPressed))
+        {
+            return false;
+        }
+        if (HasChange(changes, Change::FirstKeyPressed) && !ReadScancode(m_State.m_FirstKeyPressed))
+        {
+            return false;
+        }
+        if (HasChange(changes, Change::MousePosition))
+        {
+            if (m_Offset + sizeof(m_State.m_MousePosition) > m_Data.size)
+            {
+                return false;
+            }
+            memcpy(&m_State.m_MousePosition, m_Data.data + m_Offset, sizeof(m_State.m_MousePosition));
+            m_Offset += sizeof(m_State.m_MousePosition);
+        }
+        if (HasChange(changes, Change::MouseButtons))
+        {
+            if (m_Offset + 2 > m_Data.size)
+            {
+                return false;
+            }
+            m_State.m_MouseDownState = m_Data[m_Offset++];
+            m_State.m_MousePressedState = m_Data[m_Offset++];
+        }
+        if (HasChange(changes, Change::Controls))
+        {
+            for (auto& scancodes : m_State.controls)
+            {
+                for (SDL_Scancode& scancode : scancodes)
+                {
+                    if (!ReadScancode(scancode))
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    void Replay::Stop()
+    {
+        m_Active = false;
+    }
+
+    bool Replay::IsActive() const
+    {
+        return m_Active;
+    }
+
+    uint32_t Replay::GetStartState() const
+    {
+        return m_StartState;
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdio>
+
+#include "input.hpp"
+
+/*
+    Input recording format, written with -r and fed back into Application::Loop() with -p:
+    - The file starts with Magic, Version and the GameState the session started in
+    - Every fixed step is one frame, holding everything Input reports: held and pressed keys, the mouse and the controls
+    - A record holds the Change flags of what differs from the previous frame, then the changed parts, and the number of
+      frames after it that repeat it unchanged, packed into one header. The first record is relative to a default Input
+    - Numbers are LEB128 varints. Key sets are stored as the scancodes that flipped, each as the distance from the last one
+    - Mouse positions are in window pixels, so menu clicks only land in the same place with the same window size
+*/
+
+namespace InputRecording
+{
+    constexpr uint32_t Magic = 0x504e4950; // "PINP"
+    constexpr uint32_t Version = 1;
+
+    enum class Change : uint8_t
+    {
+        KeysDown        = 1 << 0,
+        KeysPressed     = 1 << 1,
+        FirstKeyPressed = 1 << 2,
+        MousePosition   = 1 << 3,
+        MouseButtons    = 1 << 4,
+        Controls        = 1 << 5
+    };
+
+    // Record header: the repeat count shifted past the change flags
+    constexpr int ChangeBits = 6;
+
+    // Varints of scancodes take at most two bytes
+    constexpr size_t MaxScancodeSize = 2;
+    static_assert(SDL_SCANCODE_COUNT <= 1 << 14);
+
+    // A header, both key sets flipping completely and every other part changing
+    constexpr size_t MaxRecordSize = 10 + 2 * MaxScancodeSize * (1 + SDL_SCANCODE_COUNT) + MaxScancodeSize +
+        sizeof(Math::float2) + 2 + MaxScancodeSize * 3 * (size_t)Key::Count;
+
+    class Recorder
+    {
+    public:
+        bool Start(const char* filePath, uint32_t startState);
+        // Call once per fixed step, with the input the step is about to read
+        void RecordFrame(const Input& input);
+        void Stop();
+
+        bool IsActive() const;
+        uint64_t GetFrameCount() const;
+
+    private:
+        FILE* m_File = nullptr;
+        Input m_Previous;
+
+        // The latest record is held back until a changed frame ends its run of repeats
+        uint8_t m_Record[MaxRecordSize];
+        size_t m_RecordSize = 0;
+        uint64_t m_Repeats = 0;
+        uint64_t m_FrameCount = 0;
+
+        void WriteRecord();
+    };
+
+    class Replay
+    {
+    public:
+        // The data is kept in the arena for as long as the replay runs
+        bool Load(const char* filePath, MemoryArena* arena);
+        bool Load(Span<const uint8_t> data);
+
+        // Overwrites input with the next recorded frame. Returns false once every frame has been played,
+        // or if the data turns out to be malformed, after which the replay stops
+        bool NextFrame(Input& input);
+        void Stop();
+
+        bool IsActive() const;
+        uint32_t GetStartState() const;
+
+    private:
+        Span<const uint8_t> m_Data;
+        size_t m_Offset = 0;
+        bool m_Active = false;
+
+        Input m_State;
+        uint64_t m_Repeats = 0;
+        uint32_t m_StartState = 0;
+
+        bool ReadRecord();
+    };
+}
@@ -16,6 +16,12 @@ enum class Key
     Count
 };
 
+namespace InputRecording
+{
+    class Recorder;
+    class Replay;
+}
+
 constexpr static inline std::array<StringView, (int)Key::Count> KeyNames
 {
     "Up", "Left", "Down", "Right", "Jump", "Boost"
@@ -58,4 +64,6 @@ private:
     bool IsKeyPressed(SDL_Scancode scancode) const;
 
     friend class Application;
+    friend class InputRecording::Recorder;
+    friend class InputRecording::Replay;
 };
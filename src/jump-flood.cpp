@@ -155,6 +155,8 @@ void JumpFlood::InitTextures()
     });
     for (int i = 0; i < (int)m_PingPongTextureViews.size(); i++)
     {
+        ArenaTemp scratch(&TransientArena);
+
         String label;
         label.arena = &TransientArena;
         label << "Jump Flood Slice View " << i << '\0';
@@ -144,6 +144,8 @@ void Lighting::InitTextures()
     });
     for (int i = 0; i < s_NumCascades; i++)
     {
+        ArenaTemp scratch(&TransientArena);
+
         String label;
         label.arena = &TransientArena;
         label << "Cascade Texture Slice View " << i << '\0';
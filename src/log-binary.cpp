@@ -0,0 +1,324 @@
+#include "log-binary.hpp"
+
+#include <cstdio>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+namespace Log::Binary
+{
+    static std::mutex s_FileMutex;
+    static FILE* s_File = nullptr;
+    static std::chrono::steady_clock::time_point s_StartTime;
+
+    struct ThreadChunk
+    {
+        uint8_t data[ChunkSize];
+        size_t size = 0;
+
+        // Open addressing set of the format ids defined in this chunk, zero marks an empty slot
+        std::array<uint64_t, 256> definedFormats{};
+
+        ~ThreadChunk()
+        {
+            Write();
+        }
+
+        void Write()
+        {
+            if (size > 0)
+            {
+                std::lock_guard lock(s_FileMutex);
+                if (s_File != nullptr)
+                {
+                    fwrite(data, sizeof(uint8_t), size, s_File);
+                }
+            }
+            size = 0;
+            definedFormats.fill(0);
+        }
+
+        // Returns false if the id still has to be defined, and remembers it as defined from then on
+        bool Define(uint64_t formatId)
+        {
+            if (formatId == 0)
+            {
+                return false;
+            }
+            for (size_t i = 0; i < definedFormats.size(); i++)
+            {
+                uint64_t& slot = definedFormats[(formatId + i) % definedFormats.size()];
+                if (slot == formatId)
+                {
+                    return true;
+                }
+                if (slot == 0)
+                {
+                    slot = formatId;
+                    return false;
+                }
+            }
+            // The set is full, defining the format again is harmless
+            return false;
+        }
+    };
+
+    // Allocated on the first log call, so threads that never log don't carry a chunk around
+    static thread_local std::unique_ptr<ThreadChunk> t_Chunk;
+
+    bool Start(const char* filePath)
+    {
+        assert(!IsActive() && "Binary logging has already started");
+
+        std::lock_guard lock(s_FileMutex);
+        s_File = fopen(filePath, "wb");
+        if (s_File == nullptr)
+        {
+            return false;
+        }
+        fwrite(&Magic, sizeof(Magic), 1, s_File);
+        fwrite(&Version, sizeof(Version), 1, s_File);
+
+        s_StartTime = std::chrono::steady_clock::now();
+        s_Active = true;
+        return true;
+    }
+
+    void Stop()
+    {
+        if (!IsActive())
+        {
+            return;
+        }
+        Flush();
+        s_Active = false;
+
+        std::lock_guard lock(s_FileMutex);
+        fclose(s_File);
+        s_File = nullptr;
+    }
+
+    void Flush()
+    {
+        if (t_Chunk != nullptr)
+        {
+            t_Chunk->Write();
+        }
+    }
+
+    uint8_t* BeginRecord(uint64_t formatId, StringView format, size_t argBytes)
+    {
+        if (t_Chunk == nullptr)
+        {
+            t_Chunk = std::make_unique<ThreadChunk>();
+        }
+        ThreadChunk& chunk = *t_Chunk;
+
+        uint16_t formatSize = Math::Min(format.size, (size_t)UINT16_MAX);
+        size_t definitionSize = 1 + sizeof(formatId) + sizeof(formatSize) + formatSize;
+        if (definitionSize + argBytes > ChunkSize)
+        {
+            return nullptr;
+        }
+
+        if (chunk.size + definitionSize + argBytes > ChunkSize)
+        {
+            chunk.Write();
+        }
+        if (!chunk.Define(formatId))
+        {
+            uint8_t* out = chunk.data + chunk.size;
+            *out++ = (uint8_t)RecordKind::Format;
+            memcpy(out, &formatId, sizeof(formatId));
+            out += sizeof(formatId);
+            memcpy(out, &formatSize, sizeof(formatSize));
+            out += sizeof(formatSize);
+            memcpy(out, format.data, formatSize);
+            chunk.size += definitionSize;
+        }
+        return chunk.data + chunk.size;
+    }
+
+    void EndRecord(size_t size)
+    {
+        assert(t_Chunk != nullptr && t_Chunk->size + size <= ChunkSize);
+        t_Chunk->size += size;
+    }
+
+    uint64_t GetTimestamp()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_StartTime).count();
+    }
+
+    struct Reader
+    {
+        Span<const uint8_t> data;
+        size_t offset = 0;
+
+        bool IsAtEnd() const
+        {
+            return offset == data.size;
+        }
+
+        bool Read(void* out, size_t size)
+        {
+            if (offset + size > data.size)
+            {
+                return false;
+            }
+            memcpy(out, data.data + offset, size);
+            offset += size;
+            return true;
+        }
+
+        template<typename T>
+        bool Read(T& out)
+        {
+            return Read(&out, sizeof(T));
+        }
+    };
+
+    static bool DecodeArg(Reader& reader, String& output)
+    {
+        ArgType type;
+        if (!reader.Read(type))
+        {
+            return false;
+        }
+        switch (type)
+        {
+            case ArgType::Signed:
+            {
+                int64_t num;
+                if (!reader.Read(num)) return false;
+                output.Append((long long)num);
+                return true;
+            }
+            case ArgType::Unsigned:
+            {
+                uint64_t num;
+                if (!reader.Read(num)) return false;
+                output.Append((unsigned long long)num);
+                return true;
+            }
+            case ArgType::Float:
+            {
+                double num;
+                if (!reader.Read(num)) return false;
+                output.Append(num);
+                return true;
+            }
+            case ArgType::Char:
+            {
+                char c;
+                if (!reader.Read(c)) return false;
+                output.Append(c);
+                return true;
+            }
+            case ArgType::String:
+            {
+                uint16_t size;
+                if (!reader.Read(size) || reader.offset + size > reader.data.size) return false;
+                output.Append(StringView((const char*)reader.data.data + reader.offset, size));
+                reader.offset += size;
+                return true;
+            }
+            case ArgType::Float2:
+            {
+                Math::float2 vec;
+                if (!reader.Read(vec)) return false;
+                output.Append(vec);
+                return true;
+            }
+            case ArgType::Float3:
+            {
+                Math::float3 vec;
+                if (!reader.Read(vec)) return false;
+                output.Append(vec);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool Decode(Span<const uint8_t> data, String& output)
+    {
+        Reader reader{ .data = data };
+
+        uint32_t magic, version;
+        if (!reader.Read(magic) || !reader.Read(version) || magic != Magic || version != Version)
+        {
+            return false;
+        }
+
+        constexpr StringView LevelPrefixes[] = { "[DEBUG] ", "[INFO] ", "[WARN] ", "[ERROR] " };
+
+        HashMap<uint64_t, StringView> formats;
+        formats.arena = output.arena;
+        while (!reader.IsAtEnd())
+        {
+            RecordKind kind;
+            if (!reader.Read(kind))
+            {
+                return false;
+            }
+
+            if (kind == RecordKind::Format)
+            {
+                uint64_t formatId;
+                uint16_t size;
+                if (!reader.Read(formatId) || !reader.Read(size) || reader.offset + size > data.size)
+                {
+                    return false;
+                }
+                formats[formatId] = StringView((const char*)data.data + reader.offset, size);
+                reader.offset += size;
+                continue;
+            }
+            if (kind != RecordKind::Message)
+            {
+                return false;
+            }
+
+            uint8_t level, argCount;
+            uint64_t timestamp, formatId;
+            if (!reader.Read(level) || !reader.Read(timestamp) || !reader.Read(formatId) || !reader.Read(argCount))
+            {
+                return false;
+            }
+            const StringView* format = formats.Find(formatId);
+            if (format == nullptr || level >= std::size(LevelPrefixes))
+            {
+                return false;
+            }
+
+            output << '[' << (double)timestamp / 1'000'000'000.0 << "] " << LevelPrefixes[level];
+
+            // Same rules as Log::FormatString, every unescaped % takes the next argument
+            for (size_t i = 0; i < format->size; i++)
+            {
+                char c = (*format)[i];
+                if (c == '\\' && i + 1 < format->size && (*format)[i + 1] == '%')
+                {
+                    continue;
+                }
+                if (c == '%' && (i == 0 || (*format)[i - 1] != '\\'))
+                {
+                    if (argCount == 0 || !DecodeArg(reader, output))
+                    {
+                        return false;
+                    }
+                    argCount--;
+                    continue;
+                }
+                output << c;
+            }
+            if (argCount != 0)
+            {
+                return false;
+            }
+            output << '\n';
+        }
+        return true;
+    }
+}
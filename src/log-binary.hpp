@@ -0,0 +1,164 @@
+#pragma once
+
+#include <atomic>
+
+#include "data-structures.hpp"
+
+/*
+    Binary log format, written by Log::Binary and turned back into text by the logdecode tool:
+    - The file starts with Magic and Version, followed by chunks of records
+    - Each thread fills its own chunk and appends it to the file in one write once it is full or flushed
+    - A format record defines a format string id the first time it is used in a chunk, so every chunk decodes on its own
+    - A message record holds the level, a timestamp, the format string id and the raw bytes of every argument
+*/
+
+namespace Log::Binary
+{
+    constexpr uint32_t Magic = 0x474f4c50; // "PLOG"
+    constexpr uint32_t Version = 1;
+
+    constexpr size_t ChunkSize = 64 * 1024;
+
+    enum class RecordKind : uint8_t
+    {
+        Format = 1,
+        Message = 2
+    };
+
+    enum class ArgType : uint8_t
+    {
+        Signed,
+        Unsigned,
+        Float,
+        Char,
+        String,
+        Float2,
+        Float3
+    };
+
+    // Read inline so the text path only pays for a load when binary logging is off
+    inline std::atomic<bool> s_Active = false;
+    inline bool IsActive()
+    {
+        return s_Active.load(std::memory_order_relaxed);
+    }
+
+    bool Start(const char* filePath);
+    // Writes out the calling thread's chunk and closes the file, other threads should Flush() before this
+    void Stop();
+    // Writes out the calling thread's chunk, threads also do this when they exit
+    void Flush();
+
+    // Returns where the record's bytes go in the calling thread's chunk, or nullptr if the record doesn't fit in a chunk
+    uint8_t* BeginRecord(uint64_t formatId, StringView format, size_t argBytes);
+    void EndRecord(size_t size);
+
+    uint64_t GetTimestamp();
+
+    // Strings are cut off so their length fits in 16 bits
+    template<typename T>
+    inline size_t GetEncodedSize(const T& value)
+    {
+        if constexpr (std::is_same_v<T, char>)
+        {
+            return 2;
+        }
+        else if constexpr (std::is_arithmetic_v<T>)
+        {
+            return 1 + 8;
+        }
+        else if constexpr (std::is_same_v<T, Math::float2>)
+        {
+            return 1 + sizeof(Math::float2);
+        }
+        else if constexpr (std::is_same_v<T, Math::float3>)
+        {
+            return 1 + sizeof(Math::float3);
+        }
+        else
+        {
+            return 1 + 2 + Math::Min(StringView(value).size, (size_t)UINT16_MAX);
+        }
+    }
+
+    template<typename T>
+    inline uint8_t* Encode(uint8_t* out, const T& value)
+    {
+        auto Write = [&] (ArgType type, const void* data, size_t size)
+        {
+            *out++ = (uint8_t)type;
+            memcpy(out, data, size);
+            out += size;
+        };
+
+        if constexpr (std::is_same_v<T, char>)
+        {
+            Write(ArgType::Char, &value, 1);
+        }
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+        {
+            int64_t num = value;
+            Write(ArgType::Signed, &num, sizeof(num));
+        }
+        else if constexpr (std::is_integral_v<T>)
+        {
+            uint64_t num = value;
+            Write(ArgType::Unsigned, &num, sizeof(num));
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            double num = value;
+            Write(ArgType::Float, &num, sizeof(num));
+        }
+        else if constexpr (std::is_same_v<T, Math::float2>)
+        {
+            Write(ArgType::Float2, &value, sizeof(value));
+        }
+        else if constexpr (std::is_same_v<T, Math::float3>)
+        {
+            Write(ArgType::Float3, &value, sizeof(value));
+        }
+        else
+        {
+            StringView str(value);
+            uint16_t size = Math::Min(str.size, (size_t)UINT16_MAX);
+            *out++ = (uint8_t)ArgType::String;
+            memcpy(out, &size, sizeof(size));
+            out += sizeof(size);
+            memcpy(out, str.data, size);
+            out += size;
+        }
+        return out;
+    }
+
+    // Message record header: kind, level, timestamp, format id, argument count
+    constexpr size_t MessageHeaderSize = 1 + 1 + 8 + 8 + 1;
+
+    template<typename... Args>
+    inline void Record(uint8_t level, uint64_t formatId, StringView format, const Args&... args)
+    {
+        static_assert(sizeof...(Args) < 256);
+
+        size_t size = MessageHeaderSize + (0 + ... + GetEncodedSize(args));
+        uint8_t* out = BeginRecord(formatId, format, size);
+        if (out == nullptr)
+        {
+            return;
+        }
+
+        uint64_t timestamp = GetTimestamp();
+        *out++ = (uint8_t)RecordKind::Message;
+        *out++ = level;
+        memcpy(out, &timestamp, sizeof(timestamp));
+        out += sizeof(timestamp);
+        memcpy(out, &formatId, sizeof(formatId));
+        out += sizeof(formatId);
+        *out++ = (uint8_t)sizeof...(Args);
+        ((out = Encode(out, args)), ...);
+
+        EndRecord(size);
+    }
+
+    // Renders a whole binary log as text, returns false if the data is malformed
+    bool Decode(Span<const uint8_t> data, String& output);
+}
@@ -5,8 +5,15 @@
 #include <emscripten/console.h>
 #else
 #include <cstdio>
+#include <cstdlib>
+#include <thread>
 #endif
 
+#include <atomic>
+#include <chrono>
+
+#include <stb/stb_sprintf.h>
+
 #include "utility.hpp"
 
 namespace Log
@@ -43,22 +50,417 @@ namespace Log
     constexpr static StringView ERROR_PREFIX = "[ERROR] ";
 #endif
 
-    static LogLevel s_LogLevel = LogLevel::Info;
     void SetLogLevel(LogLevel level)
     {
         s_LogLevel = level;
     }
 
+    bool StartBinaryLog(const char* filePath)
+    {
+        if (!Binary::Start(filePath))
+        {
+            Error("[LOG] Could not open binary log file '%'", StringView(filePath));
+            return false;
+        }
+        return true;
+    }
+
+    void StopBinaryLog()
+    {
+        Binary::Stop();
+    }
+
+    // Messages that were formatted before reaching the log are recorded as the single argument of "%"
+    static void RecordBinary(LogLevel level, StringView message)
+    {
+        constexpr FormatString<StringView> format("%");
+        Binary::Record((uint8_t)level, format.id, format.str, message);
+    }
+
+    // Every rate limit that has let a message through, pushed to the front when it is registered
+    static std::atomic<RateLimit*> s_RateLimitList = nullptr;
+    static float s_RateLimitInterval = 1.0f;
+    static std::chrono::steady_clock::time_point s_RateLimitIntervalStart = std::chrono::steady_clock::now();
+
+    void RateLimit::Register(LogLevel messageLevel, StringView messageFormat)
+    {
+        if (registered.exchange(true, std::memory_order_acq_rel))
+        {
+            return;
+        }
+        level = messageLevel;
+        format = messageFormat;
+        next = s_RateLimitList.load(std::memory_order_relaxed);
+        while (!s_RateLimitList.compare_exchange_weak(next, this, std::memory_order_release, std::memory_order_relaxed)) {}
+    }
+
+    void SetRateLimit(LogLevel level, uint32_t maxMessages)
+    {
+        assert(level != LogLevel::None);
+        s_RateLimits[(size_t)level] = maxMessages;
+    }
+
+    void SetRateLimitInterval(float seconds)
+    {
+        s_RateLimitInterval = seconds;
+    }
+
+    void UpdateRateLimits()
+    {
+        auto now = std::chrono::steady_clock::now();
+        if (std::chrono::duration<float>(now - s_RateLimitIntervalStart).count() < s_RateLimitInterval)
+        {
+            return;
+        }
+        s_RateLimitIntervalStart = now;
+
+        for (RateLimit* rateLimit = s_RateLimitList.load(std::memory_order_acquire); rateLimit != nullptr; rateLimit = rateLimit->next)
+        {
+            uint32_t count = rateLimit->count.exchange(0, std::memory_order_relaxed);
+            uint32_t limit = rateLimit->maxMessages != 0 ? rateLimit->maxMessages : s_RateLimits[(size_t)rateLimit->level];
+            if (count <= limit)
+            {
+                continue;
+            }
+            switch (rateLimit->level)
+            {
+                case LogLevel::Debug: Debug("[LOG] Suppressed % repeats of '%'", count - limit, rateLimit->format); break;
+                case LogLevel::Info: Info("[LOG] Suppressed % repeats of '%'", count - limit, rateLimit->format); break;
+                case LogLevel::Warn: Warn("[LOG] Suppressed % repeats of '%'", count - limit, rateLimit->format); break;
+                // Reported as a warning, so suppressed errors don't break into the debugger after all
+                default: Warn("[LOG] Suppressed % repeats of error '%'", count - limit, rateLimit->format); break;
+            }
+        }
+    }
+
+    void FormatBuffer::Append(StringView str)
+    {
+        size_t length = Math::Min(str.size, capacity - size);
+        memcpy(data + size, str.data, length);
+        size += length;
+    }
+
+    void FormatBuffer::Append(char c)
+    {
+        if (size < capacity)
+        {
+            data[size++] = c;
+        }
+    }
+
+    void FormatBuffer::Append(unsigned long long num)
+    {
+        // stbsp_snprintf() always null terminates, so format into a scratch buffer to be able to use the last byte
+        char scratch[32];
+        int length = stbsp_snprintf(scratch, sizeof(scratch), "%llu", num);
+        Append(StringView(scratch, length));
+    }
+
+    void FormatBuffer::Append(long long num)
+    {
+        char scratch[32];
+        int length = stbsp_snprintf(scratch, sizeof(scratch), "%lld", num);
+        Append(StringView(scratch, length));
+    }
+
+    void FormatBuffer::Append(double num)
+    {
+        char scratch[64];
+        int length = stbsp_snprintf(scratch, sizeof(scratch), "%f", num);
+        Append(StringView(scratch, Math::Min((size_t)length, sizeof(scratch) - 1)));
+    }
+
+    void FormatBuffer::Append(Math::float2 vec)
+    {
+        Append('(');
+        Append(vec.x);
+        Append(", ");
+        Append(vec.y);
+        Append(')');
+    }
+
+    void FormatBuffer::Append(Math::float3 vec)
+    {
+        Append('(');
+        Append(vec.x);
+        Append(", ");
+        Append(vec.y);
+        Append(", ");
+        Append(vec.z);
+        Append(')');
+    }
+
+#ifndef __EMSCRIPTEN__
+    /*
+        Async writer state:
+        - Producers claim a record with a CAS on s_EnqueuePos and publish it through the record's sequence number
+        - The single writer thread consumes records in order and writes them out in batches
+        - A full ring drops the message and counts it instead of blocking the producer
+    */
+    constexpr static size_t RingCapacity = 256;
+    static_assert(std::has_single_bit(RingCapacity));
+
+    struct LogRecord
+    {
+        std::atomic<size_t> sequence = 0;
+        bool isError = false;
+        uint32_t size = 0;
+        char text[MaxMessageSize + 32];
+    };
+    static LogRecord s_Ring[RingCapacity];
+
+    alignas(64) static std::atomic<size_t> s_EnqueuePos = 0;
+    alignas(64) static std::atomic<size_t> s_WrittenPos = 0;
+    static std::atomic<uint64_t> s_DroppedCount = 0;
+
+    static std::atomic<bool> s_AsyncRunning = false;
+    static std::atomic<bool> s_StopRequested = false;
+    static std::thread s_WriterThread;
+    static FILE* s_OutputFile = nullptr;
+
+    static void FormatLine(FormatBuffer& out, LogLevel level, StringView message, bool useColor)
+    {
+        StringView color;
+        StringView prefix;
+        switch (level)
+        {
+            case LogLevel::Debug: color = ESCAPE_COLOR_CYAN; prefix = DEBUG_PREFIX; break;
+            case LogLevel::Info: prefix = INFO_PREFIX; break;
+            case LogLevel::Warn: color = ESCAPE_COLOR_YELLOW; prefix = WARN_PREFIX; break;
+            default: color = ESCAPE_COLOR_RED; prefix = ERROR_PREFIX; break;
+        }
+        if (useColor)
+        {
+            out << color;
+        }
+        out << prefix << message;
+        // Keep room for the line ending of messages that were cut off
+        out.size = Math::Min(out.size, out.capacity - ESCAPE_COLOR_RESET.size - 1);
+        if (useColor)
+        {
+            out << ESCAPE_COLOR_RESET;
+        }
+        out << '\n';
+    }
+
+    static bool TryPush(LogLevel level, StringView message)
+    {
+        size_t pos = s_EnqueuePos.load(std::memory_order_relaxed);
+        LogRecord* record;
+        while (true)
+        {
+            record = &s_Ring[pos % RingCapacity];
+            size_t sequence = record->sequence.load(std::memory_order_acquire);
+            intptr_t difference = (intptr_t)sequence - (intptr_t)pos;
+            if (difference == 0)
+            {
+                if (s_EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = s_EnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        FormatBuffer out(record->text, sizeof(record->text));
+        FormatLine(out, level, message, s_OutputFile == nullptr);
+        record->isError = level == LogLevel::Error;
+        record->size = out.size;
+        record->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    static void WriterThread()
+    {
+        // Consecutive records going to the same stream are written with a single fwrite()
+        static char batch[64 * 1024];
+        size_t readPos = s_WrittenPos.load(std::memory_order_relaxed);
+        uint64_t reportedDrops = 0;
+
+        while (true)
+        {
+            size_t batchSize = 0;
+            FILE* batchStream = nullptr;
+            while (true)
+            {
+                LogRecord& record = s_Ring[readPos % RingCapacity];
+                if (record.sequence.load(std::memory_order_acquire) != readPos + 1)
+                {
+                    break;
+                }
+                FILE* stream = s_OutputFile != nullptr ? s_OutputFile : (record.isError ? stderr : stdout);
+                if (batchStream != stream || batchSize + record.size > sizeof(batch))
+                {
+                    if (batchSize > 0)
+                    {
+                        fwrite(batch, sizeof(char), batchSize, batchStream);
+                    }
+                    batchSize = 0;
+                    batchStream = stream;
+                }
+                memcpy(batch + batchSize, record.text, record.size);
+                batchSize += record.size;
+
+                record.sequence.store(readPos + RingCapacity, std::memory_order_release);
+                readPos++;
+            }
+            if (batchSize > 0)
+            {
+                fwrite(batch, sizeof(char), batchSize, batchStream);
+            }
+
+            uint64_t droppedCount = s_DroppedCount.load(std::memory_order_relaxed);
+            if (droppedCount != reportedDrops)
+            {
+                char messageBuffer[64];
+                StringView message = FormatTo(messageBuffer, sizeof(messageBuffer), "[LOG] Dropped % messages", droppedCount - reportedDrops);
+                char buffer[128];
+                FormatBuffer out(buffer, sizeof(buffer));
+                FormatLine(out, LogLevel::Warn, message, s_OutputFile == nullptr);
+                fwrite(out.data, sizeof(char), out.size, s_OutputFile != nullptr ? s_OutputFile : stdout);
+                reportedDrops = droppedCount;
+            }
+
+            if (batchStream != nullptr)
+            {
+                fflush(batchStream);
+            }
+            s_WrittenPos.store(readPos, std::memory_order_release);
+
+            if (batchSize == 0)
+            {
+                if (s_StopRequested.load(std::memory_order_acquire) && readPos == s_EnqueuePos.load(std::memory_order_acquire))
+                {
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+
+    bool StartAsyncWriter(const char* filePath)
+    {
+        assert(!s_AsyncRunning && "The async log writer is already running");
+        if (filePath != nullptr)
+        {
+            s_OutputFile = fopen(filePath, "wb");
+            if (s_OutputFile == nullptr)
+            {
+                Error("[LOG] Could not open log file '%'", StringView(filePath));
+                return false;
+            }
+        }
+
+        // No producer can be pushing yet, since they only use the ring once s_AsyncRunning is set
+        for (size_t i = 0; i < RingCapacity; i++)
+        {
+            s_Ring[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        s_EnqueuePos = 0;
+        s_WrittenPos = 0;
+
+        s_StopRequested = false;
+        s_WriterThread = std::thread(WriterThread);
+        s_AsyncRunning = true;
+
+        static bool registeredAtExit = false;
+        if (!registeredAtExit)
+        {
+            std::atexit(StopAsyncWriter);
+            registeredAtExit = true;
+        }
+        return true;
+    }
+
+    void StopAsyncWriter()
+    {
+        if (!s_AsyncRunning.exchange(false))
+        {
+            return;
+        }
+        s_StopRequested.store(true, std::memory_order_release);
+        s_WriterThread.join();
+        if (s_OutputFile != nullptr)
+        {
+            fclose(s_OutputFile);
+            s_OutputFile = nullptr;
+        }
+    }
+
+    void Flush()
+    {
+        if (!s_AsyncRunning.load(std::memory_order_acquire))
+        {
+            return;
+        }
+        size_t target = s_EnqueuePos.load(std::memory_order_acquire);
+        while (s_WrittenPos.load(std::memory_order_acquire) < target)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    uint64_t GetDroppedCount()
+    {
+        return s_DroppedCount.load(std::memory_order_relaxed);
+    }
+
+    static void Write(LogLevel level, StringView message)
+    {
+        if (s_AsyncRunning.load(std::memory_order_acquire))
+        {
+            if (!TryPush(level, message))
+            {
+                s_DroppedCount.fetch_add(1, std::memory_order_relaxed);
+            }
+            return;
+        }
+
+        char buffer[MaxMessageSize + 32];
+        FormatBuffer out(buffer, sizeof(buffer));
+        FormatLine(out, level, message, true);
+        FILE* stream = level == LogLevel::Error ? stderr : stdout;
+        fwrite(out.data, sizeof(char), out.size, stream);
+        fflush(stream);
+    }
+#else
+    bool StartAsyncWriter(const char* /* filePath */)
+    {
+        return false;
+    }
+
+    void StopAsyncWriter() {}
+
+    void Flush() {}
+
+    uint64_t GetDroppedCount()
+    {
+        return 0;
+    }
+#endif
+
     void Debug(StringView message)
     {
         if (s_LogLevel > LogLevel::Debug)
         {
             return;
         }
+        if (Binary::IsActive())
+        {
+            RecordBinary(LogLevel::Debug, message);
+            return;
+        }
 
+#if __EMSCRIPTEN__
         String out;
         out.arena = GetArena();
-#if __EMSCRIPTEN__
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wdollar-in-identifier-extension"
         out << message << '\0';
@@ -66,12 +468,10 @@ namespace Log
             console.debug(UTF8ToString($0));
         }, out.data);
 #pragma clang diagnostic pop
+        s_Arena.Clear();
 #else
-        out << ESCAPE_COLOR_CYAN << DEBUG_PREFIX << message << ESCAPE_COLOR_RESET << '\n';
-        fwrite(out.data, sizeof(char), out.size, stdout);
-        fflush(stdout);
+        Write(LogLevel::Debug, message);
 #endif
-        s_Arena.Clear();
     }
 
     void Info(StringView message)
@@ -80,18 +480,21 @@ namespace Log
         {
             return;
         }
+        if (Binary::IsActive())
+        {
+            RecordBinary(LogLevel::Info, message);
+            return;
+        }
 
+#if __EMSCRIPTEN__
         String out;
         out.arena = GetArena();
-#if __EMSCRIPTEN__
         out << message << '\0';
         emscripten_console_log(out.data);
+        s_Arena.Clear();
 #else
-        out << INFO_PREFIX << message << ESCAPE_COLOR_RESET << '\n';
-        fwrite(out.data, sizeof(char), out.size, stdout);
-        fflush(stdout);
+        Write(LogLevel::Info, message);
 #endif
-        s_Arena.Clear();
     }
 
     void Warn(StringView message)
@@ -100,21 +503,33 @@ namespace Log
         {
             return;
         }
+        if (Binary::IsActive())
+        {
+            RecordBinary(LogLevel::Warn, message);
+            return;
+        }
 
+#if __EMSCRIPTEN__
         String out;
         out.arena = GetArena();
-#if __EMSCRIPTEN__
         out << message << '\0';
         emscripten_console_warn(out.data);
+        s_Arena.Clear();
 #else
-        out << ESCAPE_COLOR_YELLOW << WARN_PREFIX << message << ESCAPE_COLOR_RESET << '\n';
-        fwrite(out.data, sizeof(char), out.size, stdout);
-        fflush(stdout);
+        Write(LogLevel::Warn, message);
 #endif
-        s_Arena.Clear();
     }
 
     void Error(StringView message)
+    {
+        if (Binary::IsActive() && IsEnabled(LogLevel::Error))
+        {
+            RecordBinary(LogLevel::Error, message);
+        }
+        WriteErrorText(message);
+    }
+
+    void WriteErrorText(StringView message)
     {
         Breakpoint();
 
@@ -123,15 +538,32 @@ namespace Log
             return;
         }
 
+#if __EMSCRIPTEN__
         String out;
         out.arena = GetArena();
-#if __EMSCRIPTEN__
         out << message << '\0';
         emscripten_console_error(out.data);
+        s_Arena.Clear();
 #else
-        out << ESCAPE_COLOR_RED << ERROR_PREFIX << message << ESCAPE_COLOR_RESET << '\n';
-        fwrite(out.data, sizeof(char), out.size, stderr);
+        if (!s_AsyncRunning.load(std::memory_order_acquire))
+        {
+            Write(LogLevel::Error, message);
+            return;
+        }
+
+        // Errors wait for room in the ring rather than being dropped, and are on disk before returning.
+        // Other producers can refill the ring between Flush() and TryPush(), so keep waiting until one fits
+        while (!TryPush(LogLevel::Error, message))
+        {
+            if (!s_AsyncRunning.load(std::memory_order_acquire))
+            {
+                // The writer stopped while we waited, so there is no ring left to wait on
+                Write(LogLevel::Error, message);
+                return;
+            }
+            Flush();
+        }
+        Flush();
 #endif
-        s_Arena.Clear();
     }
 }
@@ -1,8 +1,11 @@
 #pragma once
 
-#include <functional>
+#include <array>
+#include <atomic>
+#include <type_traits>
 
 #include "data-structures.hpp"
+#include "log-binary.hpp"
 
 namespace Log
 {
@@ -15,104 +18,344 @@ namespace Log
 
     void SetLogLevel(LogLevel level);
 
+    /*
+        Moves writing log messages off the calling thread:
+        - Messages are formatted on the caller and queued in a lock-free ring, a background thread writes them out in batches
+        - Messages are written to filePath, or to stdout and stderr if it is null
+        - When the ring is full the message is dropped and counted, except for errors which wait for room
+        - Error() and Flush() return once everything logged before them has been written
+        - StopAsyncWriter() writes out whatever is left, it is also run at exit
+        - Does nothing on the web, where logs go to the browser console
+    */
+    bool StartAsyncWriter(const char* filePath = nullptr);
+    void StopAsyncWriter();
+    void Flush();
+    uint64_t GetDroppedCount();
+
+    // Read inline so that filtered out messages only cost a comparison
+    inline LogLevel s_LogLevel = LogLevel::Info;
+    inline bool IsEnabled(LogLevel level)
+    {
+        return level >= s_LogLevel;
+    }
+
     void Debug(StringView message);
     void Info(StringView message);
     void Warn(StringView message);
     void Error(StringView message);
 
-    template<typename... Args>
-    inline String Format(MemoryArena* arena, StringView message, const Args&... args)
-    {
-        String output;
-        output.arena = arena;
+    // Error(StringView) without the binary log record, for callers that have already recorded the message
+    void WriteErrorText(StringView message);
 
-        size_t charactersWritten = 0;
-        bool argMismatch = false;
+    /*
+        Records messages to a binary log at filePath instead of formatting them:
+        - Debug, Info and Warn messages only go to the binary log while it is active, errors go to both
+        - Each thread buffers its records, see log-binary.hpp for the format and the logdecode tool to read it
+    */
+    bool StartBinaryLog(const char* filePath);
+    void StopBinaryLog();
+
+    // Never defined, calling it from FormatString's constructor turns a mismatch into a compile error
+    void FormatArgumentCountMismatch();
 
-        size_t expectedArgCount = 0;
-        size_t receivedArgCount = 0;
+    /*
+        A format string whose insertion points are found at compile time:
+        - Every unescaped % is replaced by the next argument, "\\%" writes a literal %
+        - The number of insertions has to match the number of arguments, or the call doesn't compile
+        - id identifies the format string in binary logs
+    */
+    template<typename... Args>
+    struct FormatString
+    {
+        StringView str;
+        uint64_t id = 0;
+        std::array<size_t, sizeof...(Args)> insertions{};
+        bool hasEscapes = false;
 
-        std::function<size_t()> FindNextInsertion = [&] ()
+        template<size_t N>
+        consteval FormatString(const char (&literal)[N])
+            : str(literal, N - 1), id(HashString(StringView(literal, N - 1)))
         {
-            size_t insertPos = String::NPOS;
-            for (size_t i = charactersWritten; i < message.size; i++)
+            size_t insertionCount = 0;
+            for (size_t i = 0; i < N - 1; i++)
             {
-                if (message[i] == '%')
+                if (literal[i] != '%')
                 {
-                    if (i != 0 && message[i - 1] == '\\')
-                    {
-                        output += message.Substr(charactersWritten, i - charactersWritten - 1);
-                        charactersWritten = i;
-                        continue;
-                    }
-                    expectedArgCount++;
-                    insertPos = i;
-                    break;
+                    continue;
                 }
+                if (i != 0 && literal[i - 1] == '\\')
+                {
+                    hasEscapes = true;
+                    continue;
+                }
+                if (insertionCount == sizeof...(Args))
+                {
+                    FormatArgumentCountMismatch();
+                }
+                insertions[insertionCount++] = i;
+            }
+            if (insertionCount != sizeof...(Args))
+            {
+                FormatArgumentCountMismatch();
             }
-            return insertPos;
-        };
+        }
+    };
 
-        ([&]
-        {
-            receivedArgCount++;
+    /*
+        Formatting output backed by a caller-provided buffer:
+        - Never allocates, text that doesn't fit is cut off
+        - Accepts the same argument types as String
+    */
+    struct FormatBuffer
+    {
+        char* data = nullptr;
+        size_t capacity = 0;
+        size_t size = 0;
+
+        FormatBuffer(char* data, size_t capacity)
+            : data(data), capacity(capacity) {}
 
-            size_t insertPos = FindNextInsertion();
-            if (insertPos == String::NPOS)
+        void Append(StringView str);
+        void Append(char c);
+        void Append(unsigned long long num);
+        void Append(long long num);
+        void Append(double num);
+        void Append(Math::float2 vec);
+        void Append(Math::float3 vec);
+
+        template<typename T>
+        inline FormatBuffer& operator<<(const T& value)
+        {
+            if constexpr (std::is_same_v<T, char>)
             {
-                argMismatch = true;
-                return;
+                Append(value);
             }
-            output << message.Substr(charactersWritten, insertPos - charactersWritten) << args;
-            charactersWritten = insertPos + 1;
-        } (), ...);
+            else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+            {
+                Append((long long)value);
+            }
+            else if constexpr (std::is_integral_v<T>)
+            {
+                Append((unsigned long long)value);
+            }
+            else if constexpr (std::is_floating_point_v<T>)
+            {
+                Append((double)value);
+            }
+            else if constexpr (std::is_same_v<T, Math::float2> || std::is_same_v<T, Math::float3>)
+            {
+                Append(value);
+            }
+            else
+            {
+                Append(StringView(value));
+            }
+            return *this;
+        }
+    };
 
-        while (true)
+    template<typename Output, typename... Args>
+    inline void WriteLiteral(Output& output, const FormatString<Args...>& format, size_t start, size_t end)
+    {
+        if (!format.hasEscapes)
         {
-            size_t insertPos = FindNextInsertion();
-            if (insertPos == String::NPOS)
+            output << format.str.Substr(start, end - start);
+            return;
+        }
+        for (size_t i = start; i < end; i++)
+        {
+            if (format.str[i] == '\\' && i + 1 < end && format.str[i + 1] == '%')
             {
-                output += message.Substr(charactersWritten);
-                break;
+                continue;
             }
-            output += message.Substr(charactersWritten, insertPos - charactersWritten);
+            output << format.str[i];
+        }
+    }
+
+    // Output can be a String or a FormatBuffer
+    template<typename Output, typename... Args>
+    inline void FormatInto(Output& output, const FormatString<Args...>& format, const Args&... args)
+    {
+        size_t charactersWritten = 0;
+        // Only read by the argument expansion below, which is empty for formats without arguments
+        [[maybe_unused]] size_t argIndex = 0;
+        ([&]
+        {
+            size_t insertPos = format.insertions[argIndex++];
+            WriteLiteral(output, format, charactersWritten, insertPos);
+            output << args;
             charactersWritten = insertPos + 1;
-            argMismatch = true;
+        } (), ...);
+        WriteLiteral(output, format, charactersWritten, format.str.size);
+    }
+
+    template<typename... Args>
+    inline String Format(MemoryArena* arena, FormatString<std::type_identity_t<Args>...> format, const Args&... args)
+    {
+        String output;
+        output.arena = arena;
+        FormatInto(output, format, args...);
+        return output;
+    }
+
+    // Formats into the buffer without allocating, the result is cut off at bufferSize characters
+    template<typename... Args>
+    inline StringView FormatTo(char* buffer, size_t bufferSize, FormatString<std::type_identity_t<Args>...> format, const Args&... args)
+    {
+        FormatBuffer output(buffer, bufferSize);
+        FormatInto(output, format, args...);
+        return StringView(output.data, output.size);
+    }
+
+    // Longer messages are cut off
+    constexpr size_t MaxMessageSize = 2048;
+
+    template<typename... Args>
+    inline void Debug(FormatString<std::type_identity_t<Args>...> format, const Args&... args)
+    {
+        if (!IsEnabled(LogLevel::Debug))
+        {
+            return;
         }
-        if (argMismatch)
+        if (Binary::IsActive())
         {
-            String errorMessage = Format(GetArena(), "Format string arg mismatch: Expected % args but received %. Message: '%'", expectedArgCount, receivedArgCount, message);
-            Error(errorMessage);
+            Binary::Record((uint8_t)LogLevel::Debug, format.id, format.str, args...);
+            return;
         }
+        char buffer[MaxMessageSize];
+        Debug(FormatTo(buffer, sizeof(buffer), format, args...));
+    }
 
-        return output;
+    template<typename... Args>
+    inline void Info(FormatString<std::type_identity_t<Args>...> format, const Args&... args)
+    {
+        if (!IsEnabled(LogLevel::Info))
+        {
+            return;
+        }
+        if (Binary::IsActive())
+        {
+            Binary::Record((uint8_t)LogLevel::Info, format.id, format.str, args...);
+            return;
+        }
+        char buffer[MaxMessageSize];
+        Info(FormatTo(buffer, sizeof(buffer), format, args...));
     }
 
     template<typename... Args>
-    inline void Debug(StringView message, const Args&... args)
+    inline void Warn(FormatString<std::type_identity_t<Args>...> format, const Args&... args)
     {
-        Debug(Format(GetArena(), message, args...));
-        GetArena()->Clear();
+        if (!IsEnabled(LogLevel::Warn))
+        {
+            return;
+        }
+        if (Binary::IsActive())
+        {
+            Binary::Record((uint8_t)LogLevel::Warn, format.id, format.str, args...);
+            return;
+        }
+        char buffer[MaxMessageSize];
+        Warn(FormatTo(buffer, sizeof(buffer), format, args...));
     }
 
+    // Always formatted, since WriteErrorText() breaks into the debugger regardless of the log level
+    // Errors also go to the binary log, but are still written as text so they are seen right away
     template<typename... Args>
-    inline void Info(StringView message, const Args&... args)
+    inline void Error(FormatString<std::type_identity_t<Args>...> format, const Args&... args)
     {
-        Info(Format(GetArena(), message, args...));
-        GetArena()->Clear();
+        if (Binary::IsActive() && IsEnabled(LogLevel::Error))
+        {
+            Binary::Record((uint8_t)LogLevel::Error, format.id, format.str, args...);
+        }
+        char buffer[MaxMessageSize];
+        WriteErrorText(FormatTo(buffer, sizeof(buffer), format, args...));
+    }
+
+    /*
+        Limits how often a single call site can log, for messages that can fire every frame:
+        - Declare one as a static next to the call site and pass it as the first argument to Debug/Info/Warn/Error
+        - At most maxMessages messages get through per interval, or the limit of the level with SetRateLimit() if it is zero
+        - A suppressed message only costs a counter increment, it is never formatted
+        - UpdateRateLimits() starts a new interval and reports how many messages each site suppressed
+    */
+    struct RateLimit
+    {
+        uint32_t maxMessages = 0;
+
+        std::atomic<uint32_t> count = 0;
+
+        // Filled in by the first message that gets through
+        std::atomic<bool> registered = false;
+        RateLimit* next = nullptr;
+        LogLevel level = LogLevel::None;
+        StringView format;
+
+        constexpr RateLimit() = default;
+        constexpr explicit RateLimit(uint32_t maxMessages)
+            : maxMessages(maxMessages) {}
+
+        bool Allow(LogLevel messageLevel, StringView messageFormat);
+
+    private:
+        void Register(LogLevel messageLevel, StringView messageFormat);
+    };
+
+    void SetRateLimit(LogLevel level, uint32_t maxMessages);
+    void SetRateLimitInterval(float seconds);
+    // Called once per frame, only starts a new interval once the last one is over
+    void UpdateRateLimits();
+
+    inline uint32_t s_RateLimits[(size_t)LogLevel::None] = { 10, 10, 10, 10 };
+
+    inline bool RateLimit::Allow(LogLevel messageLevel, StringView messageFormat)
+    {
+        uint32_t previousCount = count.fetch_add(1, std::memory_order_relaxed);
+        uint32_t limit = maxMessages != 0 ? maxMessages : s_RateLimits[(size_t)messageLevel];
+        if (previousCount >= limit)
+        {
+            return false;
+        }
+        if (!registered.load(std::memory_order_acquire))
+        {
+            Register(messageLevel, messageFormat);
+        }
+        return true;
+    }
+
+    template<typename... Args>
+    inline void Debug(RateLimit& rateLimit, FormatString<std::type_identity_t<Args>...> format, const Args&... args)
+    {
+        if (IsEnabled(LogLevel::Debug) && rateLimit.Allow(LogLevel::Debug, format.str))
+        {
+            Debug(format, args...);
+        }
+    }
+
+    template<typename... Args>
+    inline void Info(RateLimit& rateLimit, FormatString<std::type_identity_t<Args>...> format, const Args&... args)
+    {
+        if (IsEnabled(LogLevel::Info) && rateLimit.Allow(LogLevel::Info, format.str))
+        {
+            Info(format, args...);
+        }
     }
 
     template<typename... Args>
-    inline void Warn(StringView message, const Args&... args)
+    inline void Warn(RateLimit& rateLimit, FormatString<std::type_identity_t<Args>...> format, const Args&... args)
     {
-        Warn(Format(GetArena(), message, args...));
-        GetArena()->Clear();
+        if (IsEnabled(LogLevel::Warn) && rateLimit.Allow(LogLevel::Warn, format.str))
+        {
+            Warn(format, args...);
+        }
     }
 
+    // Suppressed errors don't break into the debugger either
     template<typename... Args>
-    inline void Error(StringView message, const Args&... args)
+    inline void Error(RateLimit& rateLimit, FormatString<std::type_identity_t<Args>...> format, const Args&... args)
     {
-        Error(Format(GetArena(), message, args...));
-        GetArena()->Clear();
+        if (IsEnabled(LogLevel::Error) && rateLimit.Allow(LogLevel::Error, format.str))
+        {
+            Error(format, args...);
+        }
     }
 }
@@ -17,6 +17,8 @@ static Application application;
 SDL_AppResult SDL_AppInit(void** /* state */, int argc, char** argv)
 {
     GameState startGameState = GameState::MainMenu_MainMenu;
+    const char* inputRecordingPath = nullptr;
+    const char* inputReplayPath = nullptr;
     for (int i = 1; i < argc; i++)
     {
         if (strcmp(argv[i], "-v") == 0)
@@ -31,12 +33,37 @@ SDL_AppResult SDL_AppInit(void** /* state */, int argc, char** argv)
         {
             startGameState = GameState::Editor;
         }
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc)
+        {
+            // Records to a binary log for the logdecode tool, cheap enough to capture whole sessions with -v
+            Log::StartBinaryLog(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+        {
+            // Records the input of every step, to be played back with -p
+            inputRecordingPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+        {
+            inputReplayPath = argv[++i];
+        }
+    }
+    // Keeps writing log messages off the frame, especially with -v
+    Log::StartAsyncWriter();
+
+    if (!application.Init(startGameState))
+    {
+        return SDL_APP_FAILURE;
     }
-    if (application.Init(startGameState))
+    if (inputReplayPath != nullptr && !application.StartInputReplay(inputReplayPath))
     {
-        return SDL_APP_CONTINUE;
+        return SDL_APP_FAILURE;
     }
-    return SDL_APP_FAILURE;
+    if (inputRecordingPath != nullptr && !application.StartInputRecording(inputRecordingPath))
+    {
+        return SDL_APP_FAILURE;
+    }
+    return SDL_APP_CONTINUE;
 }
 
 SDL_AppResult SDL_AppIterate(void* /* state */)
@@ -73,4 +100,6 @@ SDL_AppResult SDL_AppEvent(void* /* state */, SDL_Event* event)
 void SDL_AppQuit(void* /* state */, SDL_AppResult /* result */)
 {
     application.Exit();
+    Log::StopBinaryLog();
+    Log::StopAsyncWriter();
 }
@@ -1,7 +1,5 @@
 #include "material.hpp"
 
-#include <unordered_map>
-
 #include "config.hpp"
 #include "utility.hpp"
 #include "application.hpp"
@@ -54,17 +52,18 @@ constexpr Shader::DataType GetDataType()
 }
 
 template<typename T>
-void Material::SetUniform(StringView name, T value)
+void Material::SetUniform(StringId name, T value)
 {
     constexpr Shader::DataType inputDataType = GetDataType<T>();
 
-    auto it = shader->m_UniformMap.find(name);
-    if (it == shader->m_UniformMap.end())
+    const Shader::UniformData* uniformDataPtr = shader->m_UniformMap.Find(name);
+    if (uniformDataPtr == nullptr)
     {
-        Log::Error("Unknown uniform '%'", name);
+        static Log::RateLimit rateLimit;
+        Log::Error(rateLimit, "Unknown uniform '%'", name.GetString());
         return;
     }
-    const Shader::UniformData& uniformData = it->second;
+    const Shader::UniformData& uniformData = *uniformDataPtr;
 
     if (uniformData.dataType != inputDataType)
     {
@@ -78,31 +77,31 @@ void Material::SetUniform(StringView name, T value)
 
     updated = true;
 }
-template void Material::SetUniform<int32_t>(StringView, int32_t);
-template void Material::SetUniform<uint32_t>(StringView, uint32_t);
-template void Material::SetUniform<float>(StringView, float);
-template void Material::SetUniform<Math::int2>(StringView, Math::int2);
-template void Material::SetUniform<Math::int3>(StringView, Math::int3);
-template void Material::SetUniform<Math::int4>(StringView, Math::int4);
-template void Material::SetUniform<Math::uint2>(StringView, Math::uint2);
-template void Material::SetUniform<Math::uint3>(StringView, Math::uint3);
-template void Material::SetUniform<Math::uint4>(StringView, Math::uint4);
-template void Material::SetUniform<Math::float2>(StringView, Math::float2);
-template void Material::SetUniform<Math::float3>(StringView, Math::float3);
-template void Material::SetUniform<Math::float4>(StringView, Math::float4);
+template void Material::SetUniform<int32_t>(StringId, int32_t);
+template void Material::SetUniform<uint32_t>(StringId, uint32_t);
+template void Material::SetUniform<float>(StringId, float);
+template void Material::SetUniform<Math::int2>(StringId, Math::int2);
+template void Material::SetUniform<Math::int3>(StringId, Math::int3);
+template void Material::SetUniform<Math::int4>(StringId, Math::int4);
+template void Material::SetUniform<Math::uint2>(StringId, Math::uint2);
+template void Material::SetUniform<Math::uint3>(StringId, Math::uint3);
+template void Material::SetUniform<Math::uint4>(StringId, Math::uint4);
+template void Material::SetUniform<Math::float2>(StringId, Math::float2);
+template void Material::SetUniform<Math::float3>(StringId, Math::float3);
+template void Material::SetUniform<Math::float4>(StringId, Math::float4);
 
 template<typename T>
-T* Material::GetUniform(StringView name) const
+T* Material::GetUniform(StringId name) const
 {
     constexpr Shader::DataType inputDataType = GetDataType<T>();
 
-    auto it = shader->m_UniformMap.find(name);
-    if (it == shader->m_UniformMap.end())
+    const Shader::UniformData* uniformDataPtr = shader->m_UniformMap.Find(name);
+    if (uniformDataPtr == nullptr)
     {
-        Log::Error("Could not find uniform '%'", name);
+        Log::Error("Could not find uniform '%'", name.GetString());
         return nullptr;
     }
-    const Shader::UniformData& uniformData = it->second;
+    const Shader::UniformData& uniformData = *uniformDataPtr;
 
     if (uniformData.dataType != inputDataType)
     {
@@ -115,18 +114,18 @@ T* Material::GetUniform(StringView name) const
     static_assert(Shader::s_DataTypeSize[(int)inputDataType] == sizeof(T));
     return (T*)&data[uniformData.offset / 4];
 }
-template int32_t* Material::GetUniform<int32_t>(StringView) const;
-template uint32_t* Material::GetUniform<uint32_t>(StringView) const;
-template float* Material::GetUniform<float>(StringView) const;
-template Math::int2* Material::GetUniform<Math::int2>(StringView) const;
-template Math::int3* Material::GetUniform<Math::int3>(StringView) const;
-template Math::int4* Material::GetUniform<Math::int4>(StringView) const;
-template Math::uint2* Material::GetUniform<Math::uint2>(StringView) const;
-template Math::uint3* Material::GetUniform<Math::uint3>(StringView) const;
-template Math::uint4* Material::GetUniform<Math::uint4>(StringView) const;
-template Math::float2* Material::GetUniform<Math::float2>(StringView) const;
-template Math::float3* Material::GetUniform<Math::float3>(StringView) const;
-template Math::float4* Material::GetUniform<Math::float4>(StringView) const;
+template int32_t* Material::GetUniform<int32_t>(StringId) const;
+template uint32_t* Material::GetUniform<uint32_t>(StringId) const;
+template float* Material::GetUniform<float>(StringId) const;
+template Math::int2* Material::GetUniform<Math::int2>(StringId) const;
+template Math::int3* Material::GetUniform<Math::int3>(StringId) const;
+template Math::int4* Material::GetUniform<Math::int4>(StringId) const;
+template Math::uint2* Material::GetUniform<Math::uint2>(StringId) const;
+template Math::uint3* Material::GetUniform<Math::uint3>(StringId) const;
+template Math::uint4* Material::GetUniform<Math::uint4>(StringId) const;
+template Math::float2* Material::GetUniform<Math::float2>(StringId) const;
+template Math::float3* Material::GetUniform<Math::float3>(StringId) const;
+template Math::float4* Material::GetUniform<Math::float4>(StringId) const;
 
 void Material::Flush(wgpu::Queue queue)
 {
@@ -134,8 +133,7 @@ void Material::Flush(wgpu::Queue queue)
     Log::Debug("Material '%' flushed to GPU", name);
 }
 
-// TODO: Use an arena-friendly hash map
-static std::unordered_map<StringView, Material*> s_MaterialMap;
+static HashMap<StringId, Material*> s_MaterialMap;
 static Material* s_DefaultMaterial = nullptr;
 
 void MaterialManager::Init(const ShaderLibrary& shaderLibrary, wgpu::Device device)
@@ -143,6 +141,8 @@ void MaterialManager::Init(const ShaderLibrary& shaderLibrary, wgpu::Device devi
     Config::SetMemoryArena(&TransientArena);
     Config::Load("assets/materials.toml");
 
+    s_MaterialMap.arena = &GlobalArena;
+
     WGPUBindGroupLayoutEntry bindGroupLayoutEntry {
         .nextInChain = nullptr,
         .binding = 0,
@@ -199,46 +199,47 @@ void MaterialManager::Init(const ShaderLibrary& shaderLibrary, wgpu::Device devi
         material->data.size = materialSize;
 
         // Write material properties from config
-        for (const auto& [name, uniformData] : shader->m_UniformMap)
+        for (const auto& [id, uniformData] : shader->m_UniformMap)
         {
+            StringView name = id.GetString();
             // TOOD: Remove the need for bitcasts
             switch (uniformData.dataType)
             {
                 case Shader::DataType::Int32:
-                    material->SetUniform<int32_t>(name, Config::Get<int32_t>(name, 0));
+                    material->SetUniform<int32_t>(id, Config::Get<int32_t>(name, 0));
                     break;
                 case Shader::DataType::Uint32:
-                    material->SetUniform<uint32_t>(name, Config::Get<int32_t>(name, 0));
+                    material->SetUniform<uint32_t>(id, Config::Get<int32_t>(name, 0));
                     break;
                 case Shader::DataType::Float:
-                    material->SetUniform<float>(name, Config::Get<float>(name, 0.0f));
+                    material->SetUniform<float>(id, Config::Get<float>(name, 0.0f));
                     break;
                 case Shader::DataType::Int2:
-                    material->SetUniform<Math::uint2>(name, std::bit_cast<Math::uint2>(Config::Get<Math::int2>(name, {})));
+                    material->SetUniform<Math::uint2>(id, std::bit_cast<Math::uint2>(Config::Get<Math::int2>(name, {})));
                     break;
                 case Shader::DataType::Uint2:
-                    material->SetUniform<Math::int2>(name, Config::Get<Math::int2>(name, {}));
+                    material->SetUniform<Math::int2>(id, Config::Get<Math::int2>(name, {}));
                     break;
                 case Shader::DataType::Int3:
-                    material->SetUniform<Math::int3>(name, Config::Get<Math::int3>(name, {}));
+                    material->SetUniform<Math::int3>(id, Config::Get<Math::int3>(name, {}));
                     break;
                 case Shader::DataType::Uint3:
-                    material->SetUniform<Math::uint3>(name, std::bit_cast<Math::uint3>(Config::Get<Math::int3>(name, {})));
+                    material->SetUniform<Math::uint3>(id, std::bit_cast<Math::uint3>(Config::Get<Math::int3>(name, {})));
                     break;
                 case Shader::DataType::Int4:
-                    material->SetUniform<Math::int4>(name, Config::Get<Math::int4>(name, {}));
+                    material->SetUniform<Math::int4>(id, Config::Get<Math::int4>(name, {}));
                     break;
                 case Shader::DataType::Uint4:
-                    material->SetUniform<Math::uint4>(name, std::bit_cast<Math::uint4>(Config::Get<Math::int4>(name, {})));
+                    material->SetUniform<Math::uint4>(id, std::bit_cast<Math::uint4>(Config::Get<Math::int4>(name, {})));
                     break;
                 case Shader::DataType::Float2:
-                    material->SetUniform<Math::float2>(name, Config::Get<Math::float2>(name, 0.0f));
+                    material->SetUniform<Math::float2>(id, Config::Get<Math::float2>(name, 0.0f));
                     break;
                 case Shader::DataType::Float3:
-                    material->SetUniform<Math::float3>(name, Config::Get<Math::float3>(name, 0.0f));
+                    material->SetUniform<Math::float3>(id, Config::Get<Math::float3>(name, 0.0f));
                     break;
                 case Shader::DataType::Float4:
-                    material->SetUniform<Math::float4>(name, Config::Get<Math::float4>(name, {}));
+                    material->SetUniform<Math::float4>(id, Config::Get<Math::float4>(name, {}));
                     break;
                 default:
                     Log::Error("Invalid data type: %", (int)uniformData.dataType);
@@ -286,7 +287,7 @@ void MaterialManager::Init(const ShaderLibrary& shaderLibrary, wgpu::Device devi
         }
         else
         {
-            s_MaterialMap.insert({ material->name, material });
+            s_MaterialMap.Insert(StringId::Intern(material->name), material);
             Log::Debug("Created material '%'", material->name);
         }
 
@@ -298,17 +299,30 @@ void MaterialManager::Init(const ShaderLibrary& shaderLibrary, wgpu::Device devi
     Config::PopTable();
 }
 
+Material* MaterialManager::GetMaterial(StringId name)
+{
+    assert(s_DefaultMaterial != nullptr && "MaterialManager::Init() must be called before MaterialManager::GetMaterial()");
+
+    Material** material = s_MaterialMap.Find(name);
+    if (material == nullptr)
+    {
+        Log::Error("Could not find material (id %)", name.value);
+        return s_DefaultMaterial;
+    }
+    return *material;
+}
+
 Material* MaterialManager::GetMaterial(StringView name)
 {
     assert(s_DefaultMaterial != nullptr && "MaterialManager::Init() must be called before MaterialManager::GetMaterial()");
 
-    auto it = s_MaterialMap.find(name);
-    if (it == s_MaterialMap.end())
+    Material** material = s_MaterialMap.Find(StringId(name));
+    if (material == nullptr)
     {
         Log::Error("Could not find material '%'", name);
         return s_DefaultMaterial;
     }
-    return it->second;
+    return *material;
 }
 
 Material* MaterialManager::GetDefaultMaterial()
@@ -320,11 +334,11 @@ Array<String> MaterialManager::GetMaterialNames(MemoryArena* arena)
 {
     Array<String> names;
     names.arena = arena;
-    names.Reserve(s_MaterialMap.size());
+    names.Reserve(s_MaterialMap.size);
 
-    for (const auto& [name, _] : s_MaterialMap)
+    for (const auto& [_, material] : s_MaterialMap)
     {
-        names.Push(String::Copy(name, arena));
+        names.Push(String::Copy(material->name, arena));
     }
 
     return names;
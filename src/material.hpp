@@ -2,6 +2,7 @@
 
 #include "shader-library.hpp"
 #include "data-structures.hpp"
+#include "string-id.hpp"
 #include "renderer.hpp"
 
 #include <webgpu/webgpu.hpp>
@@ -16,10 +17,22 @@ struct Material
     bool updated = false;
 
     template<typename T>
-    void SetUniform(StringView name, T value);
+    void SetUniform(StringId name, T value);
 
     template<typename T>
-    T* GetUniform(StringView name) const;
+    T* GetUniform(StringId name) const;
+
+    template<typename T>
+    inline void SetUniform(StringView name, T value)
+    {
+        SetUniform(StringId(name), value);
+    }
+
+    template<typename T>
+    inline T* GetUniform(StringView name) const
+    {
+        return GetUniform<T>(StringId(name));
+    }
 
     void Flush(wgpu::Queue queue);
 };
@@ -28,6 +41,7 @@ namespace MaterialManager
 {
     void Init(const ShaderLibrary& shaderLibrary, wgpu::Device device);
 
+    Material* GetMaterial(StringId name);
     Material* GetMaterial(StringView name);
     Material* GetDefaultMaterial();
 
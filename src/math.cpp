@@ -179,6 +179,20 @@ namespace Math
         };
     }
 
+    bool Overlaps(const AABB& a, const AABB& b)
+    {
+        return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+               a.min.y <= b.max.y && a.max.y >= b.min.y;
+    }
+
+    AABB Union(const AABB& a, const AABB& b)
+    {
+        return {
+            .min = { Min(a.min.x, b.min.x), Min(a.min.y, b.min.y) },
+            .max = { Max(a.max.x, b.max.x), Max(a.max.y, b.max.y) }
+        };
+    }
+
     float Length(float2 in)
     {
         return std::hypot(in.x, in.y);
@@ -242,7 +256,7 @@ namespace Math
     float LerpAngleSmooth(float alpha, float beta, float deltaTime, float halfLifeSeconds)
     {
         Math::float2 direction = LerpSmooth(Direction(alpha), Direction(beta), deltaTime, halfLifeSeconds);
-        return std::atan2f(direction.y, direction.x);
+        return std::atan2(direction.y, direction.x);
     }
 
     float2 Direction(float angle)
@@ -267,6 +281,6 @@ namespace Math
 
     float2 Floor(float2 value)
     {
-        return float2(std::floorf(value.x), std::floorf(value.y));
+        return float2(std::floor(value.x), std::floor(value.y));
     }
 }
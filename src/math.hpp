@@ -115,6 +115,15 @@ namespace Math
         Matrix3x3(float3 column0, float3 column1, float3 column2);
     };
 
+    struct AABB
+    {
+        float2 min = 0.0f;
+        float2 max = 0.0f;
+    };
+
+    bool Overlaps(const AABB& a, const AABB& b);
+    AABB Union(const AABB& a, const AABB& b);
+
     float Length(float2 in);
     float LengthSquared(float2 in);
     float Distance(float2 a, float2 b);
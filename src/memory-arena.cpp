@@ -4,9 +4,72 @@
 #include <algorithm>
 #include <cassert>
 #include <bit>
+#include <vector>
 
 #include "log.hpp"
 
+#if _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    // Keeps the min and max macros from breaking std::min and std::max
+    #define NOMINMAX
+    #include <windows.h>
+#elif !__EMSCRIPTEN__
+    #include <sys/mman.h>
+#endif
+
+static void* ReserveVirtualMemory(size_t bytes)
+{
+#if _WIN32
+    return VirtualAlloc(nullptr, bytes, MEM_RESERVE, PAGE_NOACCESS);
+#elif __EMSCRIPTEN__
+    (void)bytes;
+    return nullptr;
+#else
+    void* result = mmap(nullptr, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return result == MAP_FAILED ? nullptr : result;
+#endif
+}
+
+static bool CommitVirtualMemory(void* ptr, size_t bytes)
+{
+#if _WIN32
+    return VirtualAlloc(ptr, bytes, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#elif __EMSCRIPTEN__
+    (void)ptr, (void)bytes;
+    return false;
+#else
+    return mprotect(ptr, bytes, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+// Pages are guaranteed to be zeroed when they are committed again
+static void DecommitVirtualMemory(void* ptr, size_t bytes)
+{
+#if _WIN32
+    VirtualFree(ptr, bytes, MEM_DECOMMIT);
+#elif __EMSCRIPTEN__
+    (void)ptr, (void)bytes;
+#elif __linux__
+    madvise(ptr, bytes, MADV_DONTNEED);
+    mprotect(ptr, bytes, PROT_NONE);
+#else
+    // MADV_DONTNEED does not guarantee zeroed pages outside of Linux, so we map fresh pages over the range instead
+    mmap(ptr, bytes, PROT_NONE, MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+#endif
+}
+
+static void ReleaseVirtualMemory(void* ptr, size_t bytes)
+{
+#if _WIN32
+    (void)bytes;
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#elif __EMSCRIPTEN__
+    (void)ptr, (void)bytes;
+#else
+    munmap(ptr, bytes);
+#endif
+}
+
 size_t Align(size_t bytes, size_t alignment)
 {
     assert(std::has_single_bit(alignment));
@@ -17,6 +80,36 @@ void MemoryArena::Init(size_t bytes, size_t flags)
 {
     assert(data == nullptr && "Free() must be called before calling Init() again");
 
+#if __EMSCRIPTEN__
+    flags &= ~MemoryArenaFlags_VirtualMemory;
+#endif
+
+    if (flags & MemoryArenaFlags_VirtualMemory)
+    {
+        size = VirtualReserveSize;
+        offset = 0;
+        committed = 0;
+        retained = Align(std::max(bytes, (size_t)1), VirtualCommitGranularity);
+        this->flags = flags;
+
+        data = ReserveVirtualMemory(size);
+        if (data == nullptr)
+        {
+            std::abort();
+        }
+        Commit(retained);
+
+#if DEBUG
+        NumActiveArenas++;
+#endif
+
+        if ((flags & MemoryArenaFlags_NoLog) == 0)
+        {
+            Log::Debug("Memory Arena Reservation (% bytes reserved, % bytes committed)", size, committed);
+        }
+        return;
+    }
+
     // We store memory for the next MemoryArena at the end of the allocated block
     // We pretend this memory doesn't exist so we don't return allocations that intrude this space
     size_t requestedSize = Align(bytes, alignof(MemoryArena));
@@ -56,9 +149,19 @@ void MemoryArena::Init(size_t bytes, size_t flags)
 
 void MemoryArena::Clear()
 {
+    size_t usedSize = offset;
+    if ((flags & MemoryArenaFlags_VirtualMemory) && committed > retained)
+    {
+        DecommitVirtualMemory((char*)data + retained, committed - retained);
+#if DEBUG
+        TotalAllocationSize -= committed - retained;
+#endif
+        committed = retained;
+        usedSize = std::min(usedSize, retained);
+    }
     if (flags & MemoryArenaFlags_ClearToZero)
     {
-        memset(data, 0, offset);
+        memset(data, 0, usedSize);
     }
     offset = 0;
     if (next != nullptr)
@@ -74,26 +177,48 @@ void MemoryArena::Free()
         next->Free();
     }
 
-    free(data);
+    if (flags & MemoryArenaFlags_VirtualMemory)
+    {
+        ReleaseVirtualMemory(data, size);
+#if DEBUG
+        TotalAllocationSize -= committed;
+#endif
+    }
+    else
+    {
+        free(data);
+#if DEBUG
+        TotalAllocationSize -= size + sizeof(MemoryArena);
+#endif
+    }
 
 #if DEBUG
     NumActiveArenas--;
-    TotalAllocationSize -= size + sizeof(MemoryArena);
 #endif
 
     data = nullptr;
     size = 0;
     offset = 0;
-
+    committed = 0;
+    retained = 0;
 }
 
 void* MemoryArena::Alloc(size_t bytes, size_t alignment)
 {
-    assert(data != nullptr && bytes > 0);
+    assert((data != nullptr || concurrentArena != nullptr) && bytes > 0);
 
     void* result = nullptr;
 
     size_t newOffset = Align(offset, alignment);
+    if ((flags & MemoryArenaFlags_VirtualMemory) && newOffset + bytes > committed)
+    {
+        Commit(newOffset + bytes);
+    }
+    if (newOffset + bytes > size && concurrentArena != nullptr)
+    {
+        concurrentArena->Refill(*this, bytes + alignment);
+        newOffset = Align(offset, alignment);
+    }
     if (newOffset + bytes > size)
     {
         if (next == nullptr)
@@ -125,7 +250,8 @@ void* MemoryArena::Realloc(void* prevData, size_t prevSize, size_t newSize, size
     {
         if ((flags & MemoryArenaFlags_NoLog) == 0)
         {
-            Log::Warn("Redundant realloc! (% bytes)", newSize);
+            static Log::RateLimit rateLimit;
+            Log::Warn(rateLimit, "Redundant realloc! (% bytes)", newSize);
         }
         return prevData;
     }
@@ -133,6 +259,13 @@ void* MemoryArena::Realloc(void* prevData, size_t prevSize, size_t newSize, size
     // If it's not in this block, try the next one
     if (prevData < data || prevData >= (char*)data + size)
     {
+        if (concurrentArena != nullptr)
+        {
+            // The allocation is in a previous chunk, so it can never grow in place
+            void* newData = Alloc(newSize, alignment);
+            memcpy(newData, prevData, std::min(prevSize, newSize));
+            return newData;
+        }
         assert(next != nullptr);
         return next->Realloc(prevData, prevSize, newSize, alignment);
     }
@@ -162,6 +295,27 @@ void* MemoryArena::Realloc(void* prevData, size_t prevSize, size_t newSize, size
     return newData;
 }
 
+void MemoryArena::Commit(size_t bytes)
+{
+    assert(flags & MemoryArenaFlags_VirtualMemory);
+
+    size_t newCommitted = Align(bytes, VirtualCommitGranularity);
+    if (newCommitted <= committed)
+    {
+        return;
+    }
+    // Running out of reserved address space is treated the same as malloc() failing
+    if (newCommitted > size || !CommitVirtualMemory((char*)data + committed, newCommitted - committed))
+    {
+        std::abort();
+    }
+
+#if DEBUG
+    TotalAllocationSize += newCommitted - committed;
+#endif
+    committed = newCommitted;
+}
+
 MemoryArena* MemoryArena::GetFooter()
 {
     return (MemoryArena*)((char*)data + size);
@@ -176,7 +330,7 @@ MemoryArena* MemoryArena::GetFooter()
         // We don't include the footer in the memory info
         // TODO: Should we?
         size_t usedMemory = offset;
-        size_t allocatedMemory = size;
+        size_t allocatedMemory = (flags & MemoryArenaFlags_VirtualMemory) ? committed : size;
         if (next != nullptr)
         {
             MemoryInfo info = next->GetMemoryInfo();
@@ -189,3 +343,318 @@ MemoryArena* MemoryArena::GetFooter()
         };
     }
 #endif
+
+ArenaTemp::ArenaTemp(MemoryArena* arena)
+{
+    assert(arena != nullptr);
+
+    size_t numBlocks = 0;
+    for (MemoryArena* current = arena; current != nullptr && current->data != nullptr; current = current->next)
+    {
+        numBlocks++;
+    }
+
+    block = arena;
+    for (size_t i = 0; numBlocks > MaxSavedBlocks && i < numBlocks - MaxSavedBlocks; i++)
+    {
+        block = block->next;
+    }
+    data = block->data;
+
+    for (MemoryArena* current = block; current != nullptr && current->data != nullptr; current = current->next)
+    {
+        offsets[numSavedBlocks++] = current->offset;
+    }
+}
+
+ArenaTemp::~ArenaTemp()
+{
+    // A ConcurrentArena thread arena can swap to a new chunk, in which case the old position no longer exists
+    if (block->data != data)
+    {
+        return;
+    }
+
+    size_t index = 0;
+    for (MemoryArena* current = block; current != nullptr && current->data != nullptr; current = current->next)
+    {
+        // Blocks that were chained while the savepoint was alive are emptied completely
+        size_t rewindOffset = index < numSavedBlocks ? offsets[index] : 0;
+        index++;
+
+        assert(current->offset >= rewindOffset);
+        if (current->flags & MemoryArenaFlags_ClearToZero)
+        {
+            memset((char*)current->data + rewindOffset, 0, current->offset - rewindOffset);
+        }
+        current->offset = rewindOffset;
+    }
+}
+
+void* MemoryPool::Alloc(size_t bytes, size_t alignment)
+{
+    assert(arena != nullptr && bytes > 0);
+    assert(alignment <= MinBlockSize && "MemoryPool blocks are only aligned to MinBlockSize");
+
+    if (bytes > MaxBlockSize)
+    {
+        return arena->Alloc(bytes, alignment);
+    }
+
+    size_t sizeClass = GetSizeClass(bytes);
+    size_t blockSize = GetBlockSize(sizeClass);
+
+    if (freeLists[sizeClass] == nullptr)
+    {
+        // Carve a new slab into blocks and thread them onto the free list
+        size_t numBlocks = std::max(SlabSize / blockSize, (size_t)1);
+        char* slab = (char*)arena->Alloc(numBlocks * blockSize, MinBlockSize);
+        for (size_t i = 0; i < numBlocks; i++)
+        {
+            void* block = slab + i * blockSize;
+            *(void**)block = (i + 1 < numBlocks) ? slab + (i + 1) * blockSize : nullptr;
+        }
+        freeLists[sizeClass] = slab;
+    }
+
+    void* block = freeLists[sizeClass];
+    freeLists[sizeClass] = *(void**)block;
+
+    if (arena->flags & MemoryArenaFlags_ClearToZero)
+    {
+        memset(block, 0, blockSize);
+    }
+    return block;
+}
+
+void* MemoryPool::Realloc(void* prevData, size_t prevSize, size_t newSize, size_t alignment)
+{
+    assert(prevData != nullptr);
+
+    if (prevSize <= MaxBlockSize && newSize <= MaxBlockSize && GetSizeClass(prevSize) == GetSizeClass(newSize))
+    {
+        if (newSize < prevSize && (arena->flags & MemoryArenaFlags_ClearToZero))
+        {
+            memset((char*)prevData + newSize, 0, prevSize - newSize);
+        }
+        return prevData;
+    }
+
+    void* newData = Alloc(newSize, alignment);
+    memcpy(newData, prevData, std::min(prevSize, newSize));
+    Free(prevData, prevSize);
+    return newData;
+}
+
+void MemoryPool::Free(void* data, size_t bytes)
+{
+    if (data == nullptr || bytes > MaxBlockSize)
+    {
+        return;
+    }
+
+    size_t sizeClass = GetSizeClass(bytes);
+    *(void**)data = freeLists[sizeClass];
+    freeLists[sizeClass] = data;
+}
+
+void MemoryPool::Reset()
+{
+    freeLists.fill(nullptr);
+}
+
+size_t MemoryPool::GetSizeClass(size_t bytes)
+{
+    assert(bytes > 0 && bytes <= MaxBlockSize);
+    size_t blockSize = std::max(std::bit_ceil(bytes), MinBlockSize);
+    return std::countr_zero(blockSize) - std::countr_zero(MinBlockSize);
+}
+
+size_t MemoryPool::GetBlockSize(size_t sizeClass)
+{
+    assert(sizeClass < NumSizeClasses);
+    return MinBlockSize << sizeClass;
+}
+
+struct ConcurrentArenaSlots
+{
+    std::mutex mutex;
+    std::array<uint32_t, ConcurrentArena::MaxThreads> free;
+    size_t freeCount = 0;
+
+    // Set by Free(), after which threads forget the slot they hold instead of looking it up again
+    std::atomic<bool> retired = false;
+};
+
+namespace
+{
+    // The slots the calling thread holds in every arena it has used, given back when the thread exits
+    struct ThreadSlotLeases
+    {
+        struct Lease
+        {
+            std::shared_ptr<ConcurrentArenaSlots> slots;
+            uint32_t index;
+        };
+        std::vector<Lease> leases;
+
+        ~ThreadSlotLeases()
+        {
+            for (Lease& lease : leases)
+            {
+                std::lock_guard<std::mutex> lock(lease.slots->mutex);
+                lease.slots->free[lease.slots->freeCount++] = lease.index;
+            }
+        }
+    };
+
+    thread_local ThreadSlotLeases t_SlotLeases;
+}
+
+// Chained blocks are kept by Clear(), so they still count as allocated
+static size_t GetChainedSize(const MemoryArena& arena)
+{
+    size_t size = 0;
+    for (const MemoryArena* block = &arena; block != nullptr; block = block->next)
+    {
+        size += block->size;
+    }
+    return size;
+}
+
+void ConcurrentArena::Init(size_t bytes, size_t flags)
+{
+    // Thread arenas must never log, since logging goes through a single global arena
+    m_Backing.Init(bytes, flags | MemoryArenaFlags_VirtualMemory | MemoryArenaFlags_NoLog);
+    m_Offset = 0;
+    m_Committed = (m_Backing.flags & MemoryArenaFlags_VirtualMemory) ? m_Backing.committed : m_Backing.size;
+
+    for (ThreadSlot& slot : m_ThreadSlots)
+    {
+        slot.arena = MemoryArena {
+            .flags = (m_Backing.flags & ~MemoryArenaFlags_VirtualMemory) | MemoryArenaFlags_NoLog,
+            .concurrentArena = this
+        };
+    }
+
+    // Handed out from the back, so the first thread gets slot 0
+    m_FreeSlots = std::make_shared<ConcurrentArenaSlots>();
+    for (uint32_t i = 0; i < MaxThreads; i++)
+    {
+        m_FreeSlots->free[i] = MaxThreads - 1 - i;
+    }
+    m_FreeSlots->freeCount = MaxThreads;
+}
+
+void ConcurrentArena::Clear()
+{
+    if (m_Backing.flags & MemoryArenaFlags_VirtualMemory)
+    {
+        // The backing arena's offset is never used for allocations, so we let its Clear() zero and decommit the used range
+        m_Backing.offset = std::min(m_Offset.load(), m_Committed.load());
+    }
+    m_Backing.Clear();
+    m_Offset = 0;
+    m_Committed = (m_Backing.flags & MemoryArenaFlags_VirtualMemory) ? m_Backing.committed : GetChainedSize(m_Backing);
+
+    for (ThreadSlot& slot : m_ThreadSlots)
+    {
+        slot.arena.data = nullptr;
+        slot.arena.size = 0;
+        slot.arena.offset = 0;
+    }
+}
+
+void ConcurrentArena::Free()
+{
+    m_Backing.Free();
+    m_Offset = 0;
+    m_Committed = 0;
+
+    for (ThreadSlot& slot : m_ThreadSlots)
+    {
+        slot.arena = MemoryArena{};
+    }
+
+    // Threads that still hold a slot keep the old list alive until they exit
+    if (m_FreeSlots != nullptr)
+    {
+        m_FreeSlots->retired = true;
+        m_FreeSlots = nullptr;
+    }
+}
+
+MemoryArena* ConcurrentArena::GetThreadArena()
+{
+    assert(m_FreeSlots != nullptr && "Init() must be called before GetThreadArena()");
+
+    auto& leases = t_SlotLeases.leases;
+    for (size_t i = 0; i < leases.size(); i++)
+    {
+        if (leases[i].slots == m_FreeSlots)
+        {
+            return &m_ThreadSlots[leases[i].index].arena;
+        }
+        if (leases[i].slots->retired)
+        {
+            leases[i--] = std::move(leases.back());
+            leases.pop_back();
+        }
+    }
+
+    uint32_t index;
+    {
+        std::lock_guard<std::mutex> lock(m_FreeSlots->mutex);
+        if (m_FreeSlots->freeCount == 0)
+        {
+            // More than MaxThreads threads are using the arena at the same time
+            std::abort();
+        }
+        index = m_FreeSlots->free[--m_FreeSlots->freeCount];
+    }
+    leases.push_back({ m_FreeSlots, index });
+    return &m_ThreadSlots[index].arena;
+}
+
+void ConcurrentArena::Refill(MemoryArena& arena, size_t bytes)
+{
+    assert(arena.concurrentArena == this);
+
+    size_t chunkSize = Align(std::max(bytes, ChunkSize), 64);
+
+    if ((m_Backing.flags & MemoryArenaFlags_VirtualMemory) == 0)
+    {
+        // The backing block can't grow in place, so chunks come from blocks chained onto it one thread at a time
+        std::lock_guard<std::mutex> lock(m_CommitMutex);
+        arena.data = m_Backing.Alloc(chunkSize, 64);
+        arena.size = chunkSize;
+        arena.offset = 0;
+        m_Offset += chunkSize;
+        m_Committed = GetChainedSize(m_Backing);
+        return;
+    }
+
+    size_t chunkStart = m_Offset.fetch_add(chunkSize, std::memory_order_relaxed);
+    size_t chunkEnd = chunkStart + chunkSize;
+
+    if (chunkEnd > m_Committed.load(std::memory_order_acquire))
+    {
+        std::lock_guard<std::mutex> lock(m_CommitMutex);
+        m_Backing.Commit(chunkEnd);
+        m_Committed.store(m_Backing.committed, std::memory_order_release);
+    }
+
+    arena.data = (char*)m_Backing.data + chunkStart;
+    arena.size = chunkSize;
+    arena.offset = 0;
+}
+
+#if DEBUG
+    MemoryArena::MemoryInfo ConcurrentArena::GetMemoryInfo() const
+    {
+        return {
+            .usedMemory = m_Offset.load(),
+            .allocatedMemory = m_Committed.load()
+        };
+    }
+#endif
@@ -2,6 +2,11 @@
 
 #include <cstddef>
 #include <type_traits>
+#include <atomic>
+#include <mutex>
+#include <array>
+#include <memory>
+#include <bit>
 
 size_t Align(size_t bytes, size_t alignment);
 
@@ -12,14 +17,19 @@ enum MemoryArenaFlags : size_t
     MemoryArenaFlags_ClearToZero = 1 << 0,
 
     // Prevents MemoryArena from calling any logging functions
-    MemoryArenaFlags_NoLog = 1 << 1
+    MemoryArenaFlags_NoLog = 1 << 1,
+
+    // Reserves a large range of virtual memory and commits pages as the offset moves forward
+    // The arena never chains to a new block, so growing the most recent allocation never copies
+    // The size passed to Init() is committed up front, and anything committed past it is given
+    // back to the OS on Clear()
+    // This flag is ignored on platforms without virtual memory (e.g. Emscripten)
+    MemoryArenaFlags_VirtualMemory = 1 << 2
 };
 
-// TODO: The current implementation uses malloc() and free(), but maybe we can take advantage
-//   of 64-bit address spaces to rid the need of a linked-list of arenas for growing (e.g. use
-//   VirtualAlloc() or mmap() and reserve a large portion of virtual memory)
+// NOTE: This arena is NOT thread safe. Use ConcurrentArena::GetThreadArena() to allocate from worker threads
 
-// NOTE: This arena is NOT thread safe
+struct ConcurrentArena;
 
 struct MemoryArena
 {
@@ -28,8 +38,15 @@ struct MemoryArena
     size_t offset = 0;
     size_t flags = 0;
 
+    // Only used with MemoryArenaFlags_VirtualMemory, where size is the reserved address space
+    size_t committed = 0;
+    size_t retained = 0;
+
     MemoryArena* next = nullptr;
 
+    // Set on the per-thread arenas owned by a ConcurrentArena, which refills this arena instead of chaining
+    ConcurrentArena* concurrentArena = nullptr;
+
     void Init(size_t bytes, size_t flags);
     void Clear();
     void Free();
@@ -55,8 +72,14 @@ struct MemoryArena
         return (T*)Realloc(prevData, sizeof(T) * prevLength, sizeof(T) * newLength, alignof(T));
     }
 
+    // Commits pages until at least the first `bytes` bytes are usable (MemoryArenaFlags_VirtualMemory only)
+    void Commit(size_t bytes);
+
     MemoryArena* GetFooter();
 
+    static constexpr size_t VirtualReserveSize = sizeof(size_t) == 8 ? (size_t)64 << 30 : (size_t)256 << 20;
+    static constexpr size_t VirtualCommitGranularity = 64 * 1024;
+
     // We expose information about the arenas in debug mode to make sure things don't get out of hand
     #if DEBUG
         // The total number of arenas that have been initialized and not freed. This includes the new arenas
@@ -77,3 +100,110 @@ struct MemoryArena
         MemoryInfo GetMemoryInfo() const;
     #endif
 };
+
+// Saves the current position of an arena and rewinds back to it when the savepoint goes out of scope
+// Nothing allocated from the arena while the savepoint is alive may be used after it is destroyed
+// NOTE: Only the offsets of the last MaxSavedBlocks chained blocks are saved. Allocations squeezed into
+//   the leftover space of even earlier blocks are only reclaimed by Clear()
+struct ArenaTemp
+{
+    static constexpr size_t MaxSavedBlocks = 16;
+
+    // The first block whose offset was saved
+    MemoryArena* block = nullptr;
+    void* data = nullptr;
+
+    size_t numSavedBlocks = 0;
+    std::array<size_t, MaxSavedBlocks> offsets{};
+
+    explicit ArenaTemp(MemoryArena* arena);
+    ~ArenaTemp();
+
+    ArenaTemp(const ArenaTemp&) = delete;
+    ArenaTemp& operator=(const ArenaTemp&) = delete;
+};
+
+/*
+    A pool allocator that recycles fixed-size blocks:
+    - Requests are rounded up to a power-of-two size class between MinBlockSize and MaxBlockSize
+    - Slabs of blocks are drawn from the arena, and freed blocks are kept in an intrusive free list per size class
+    - Requests larger than MaxBlockSize come straight from the arena and are only reclaimed when it is cleared
+    - Reset() must be called whenever the arena is cleared, since the free lists point into its memory
+*/
+
+struct MemoryPool
+{
+    static constexpr size_t MinBlockSize = 16;
+    static constexpr size_t MaxBlockSize = 2048;
+    static constexpr size_t NumSizeClasses = std::countr_zero(MaxBlockSize) - std::countr_zero(MinBlockSize) + 1;
+    static constexpr size_t SlabSize = 4096;
+
+    MemoryArena* arena = nullptr;
+    std::array<void*, NumSizeClasses> freeLists{};
+
+    void* Alloc(size_t bytes, size_t alignment);
+
+    // Returns prevData if the new size still fits in the same size class
+    void* Realloc(void* prevData, size_t prevSize, size_t newSize, size_t alignment);
+
+    // The size must be the same size that was passed to Alloc() or Realloc()
+    void Free(void* data, size_t bytes);
+
+    void Reset();
+
+    static size_t GetSizeClass(size_t bytes);
+    static size_t GetBlockSize(size_t sizeClass);
+};
+
+/*
+    A thread safe arena that hands each thread its own chunk of a shared virtual memory block:
+    - GetThreadArena() returns a MemoryArena that can be passed to Array, String, etc. on the calling thread
+    - Each thread holds one of the arena's slots until it exits, so at most MaxThreads threads can use it at once
+    - Threads bump allocate from their chunk, and refill it from the shared block with a single atomic add
+    - Without virtual memory (e.g. Emscripten) the shared block can't grow, so refills chain blocks under a lock instead
+    - Clear() resets every thread's chunk at once, but must not run while any thread is allocating
+*/
+
+// Which of a ConcurrentArena's slots are free, shared with the threads holding them so they can outlive Free()
+struct ConcurrentArenaSlots;
+
+struct ConcurrentArena
+{
+    static constexpr size_t MaxThreads = 64;
+    static constexpr size_t ChunkSize = 64 * 1024;
+
+    void Init(size_t bytes, size_t flags);
+    void Clear();
+    void Free();
+
+    MemoryArena* GetThreadArena();
+
+    // Gives `arena` a new chunk that can fit at least `bytes` bytes
+    void Refill(MemoryArena& arena, size_t bytes);
+
+    #if DEBUG
+        MemoryArena::MemoryInfo GetMemoryInfo() const;
+    #endif
+
+private:
+    MemoryArena m_Backing;
+
+    std::atomic<size_t> m_Offset = 0;
+    std::atomic<size_t> m_Committed = 0;
+    std::mutex m_CommitMutex;
+
+    // Each arena sits on its own cache line so threads don't fight over their offsets
+    struct alignas(64) ThreadSlot
+    {
+        MemoryArena arena;
+    };
+    std::array<ThreadSlot, MaxThreads> m_ThreadSlots;
+    std::shared_ptr<ConcurrentArenaSlots> m_FreeSlots;
+};
+
+// Defined by each executable that uses them, the game in application.cpp and tools/simulate.cpp
+// Memory allocated with this arena will persist for the entire duration of the program
+extern MemoryArena GlobalArena;
+
+// Memory allocated in this arena will be cleared at the beginning of every frame
+extern MemoryArena TransientArena;
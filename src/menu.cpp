@@ -2,9 +2,9 @@
 #include "shader-library.hpp"
 #include "material.hpp"
 
-void Menu::Init(MemoryArena* arena)
+void Menu::Init()
 {
-    scene.Init(arena);
+    scene.Init();
 }
 
 void Menu::Begin(Math::float2 mousePosition, bool mousePressed)
@@ -12,10 +12,6 @@ void Menu::Begin(Math::float2 mousePosition, bool mousePressed)
     m_MousePosition = mousePosition;
     m_MousePressed = mousePressed;
 
-    for (Entity& entity : scene.entities)
-    {
-        entity.flags |= (uint16_t)EntityFlags::Hidden;
-    }
     scene.Clear();
 }
 
@@ -35,9 +31,8 @@ void Menu::Text(StringView text, Math::float2 center, float scale)
 
     Entity* entity = scene.CreateEntity();
     entity->name += text;
-    entity->flags = (uint16_t)EntityFlags::Text;
-    entity->transform.position = center;
-    entity->transform.scale = scale;
+    scene.SetFlags(entity, (uint16_t)EntityFlags::Text);
+    scene.SetTransform(entity, Transform(center, scale));
     entity->material = m_TextMaterial;
 }
 
@@ -46,17 +41,15 @@ bool Menu::Button(StringView text, Math::float2 center, Math::float2 extent, Mat
     assert(m_ButtonMaterial != nullptr && m_TextMaterial != nullptr);
 
     Entity* entity = scene.CreateEntity();
-    entity->flags = (uint16_t)EntityFlags::None;
-    entity->transform.position = center;
-    entity->transform.scale = extent + padding;
+    scene.SetFlags(entity, (uint16_t)EntityFlags::None);
+    scene.SetTransform(entity, Transform(center, extent + padding));
     entity->shape = Shape::Rectangle;
     entity->material = m_ButtonMaterial;
 
     entity = scene.CreateEntity();
     entity->name += text;
-    entity->flags = (uint16_t)EntityFlags::Text;
-    entity->transform.position = center;
-    entity->transform.scale = extent.y;
+    scene.SetFlags(entity, (uint16_t)EntityFlags::Text);
+    scene.SetTransform(entity, Transform(center, extent.y));
     entity->material = m_TextMaterial;
 
     if (!m_MousePressed)
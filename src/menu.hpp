@@ -9,7 +9,7 @@ class Menu
 public:
     Scene scene;
 
-    void Init(MemoryArena* arena);
+    void Init();
 
     void Begin(Math::float2 mousePosition, bool mousePressed);
 
@@ -1,60 +1,73 @@
 #include "physics.hpp"
 #include "math.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 
 namespace Physics
 {
     GravityZoneInfo GetGravity(const Scene& scene, Math::float2 position, Math::float2 currentGravity)
     {
+        static const float MinRadialAlignment = std::acos(M_PI_4);
+
+        Span<const Math::float2> positions = scene.GetPositions();
+        Span<const Math::float2> scales = scene.GetScales();
+        Span<const uint16_t> zIndices = scene.GetZIndices();
+
         GravityZoneInfo closestGravityZoneInfo { .active = false };
         uint16_t highestZIndex = 0;
+        uint32_t highestIndex = 0;
 
-        auto RegisterGravityZoneInfo = [&](const GravityZoneInfo&& info, Entity* entity)
+        // Zones are visited in no particular order, so equal z-indices are settled by handle index
+        auto RegisterGravityZoneInfo = [&](const GravityZoneInfo&& info, uint32_t index)
         {
-            if (entity->zIndex >= highestZIndex)
+            if (!closestGravityZoneInfo.active || zIndices[index] > highestZIndex ||
+                (zIndices[index] == highestZIndex && index > highestIndex))
             {
                 closestGravityZoneInfo = info;
-                highestZIndex = entity->zIndex;
+                highestZIndex = zIndices[index];
+                highestIndex = index;
             }
         };
 
-        for (Entity& entity : scene.entities)
+        scene.GetGravityZoneGrid().Query({ .min = position, .max = position }, [&](Entity* entityPtr)
         {
-            if ((entity.flags & (uint16_t)EntityFlags::GravityZone) == 0)
-            {
-                continue;
-            }
-            Math::float2 rotatedPosition = entity.transform.position + Math::RotateVector(position - entity.transform.position, -entity.transform.rotation);
+            Entity& entity = *entityPtr;
+            uint32_t index = entity.handle.GetIndex();
+            Math::float2 zonePosition = positions[index];
+            Math::float2 zoneScale = scales[index];
+            const ColliderGeometry& geometry = scene.GetColliderGeometry(entity);
+            Math::float2 rotatedPosition = zonePosition + geometry.inverseRotation * (position - zonePosition);
             switch (entity.shape)
             {
                 case Shape::Rectangle: {
-                    Math::float2 min = entity.transform.position - entity.transform.scale;
-                    Math::float2 max = entity.transform.position + entity.transform.scale;
+                    Math::float2 min = zonePosition - zoneScale;
+                    Math::float2 max = zonePosition + zoneScale;
                     if (rotatedPosition.x >= min.x && rotatedPosition.x <= max.x &&
                         rotatedPosition.y >= min.y && rotatedPosition.y <= max.y)
                     {
-                        Math::float2 direction = Math::Direction(entity.transform.rotation - Math::PI / 2.0f);
+                        Math::float2 direction = geometry.downDirection;
                         RegisterGravityZoneInfo({
                             .active = true,
                             .shape = Shape::Rectangle,
                             .direction = direction,
                             .closestEndDirection = direction,
-                            .position = entity.transform.position,
-                            .radius = entity.transform.scale.x
-                        }, &entity);
+                            .position = zonePosition,
+                            .radius = zoneScale.x
+                        }, index);
                     }
                     break;
                 }
                 case Shape::Ellipse: {
-                    Math::float2 zoneCenter = entity.transform.position;
-                    float zoneRadius = entity.transform.scale.x;
+                    Math::float2 zoneCenter = zonePosition;
+                    float zoneRadius = zoneScale.x;
                     if (Math::Distance(position, zoneCenter) > zoneRadius)
                     {
                         break;
                     }
                     Math::float2 direction = Math::Normalize(zoneCenter - position);
-                    if (Math::Dot(currentGravity, direction) < std::acos(M_PI_4))
+                    if (Math::Dot(currentGravity, direction) < MinRadialAlignment)
                     {
                         break;
                     }
@@ -78,233 +91,240 @@ namespace Physics
                             .closestEndDirection = closestEndDirection,
                             .position = zoneCenter,
                             .radius = zoneRadius
-                        }, &entity);
+                        }, index);
                     }
                     break;
                 }
             }
-        }
+        });
         return closestGravityZoneInfo;
     }
 
-    Math::float2 CollideAndSlide(const Scene& scene, const Transform& ellipse, Math::float2 velocity, std::function<bool(CollisionData)> callback)
+    bool QueryFilter::Accepts(uint16_t entityFlags, const Entity& entity) const
     {
-        constexpr int MAX_ITERATIONS = 5;
-        constexpr float SMALL_DISTANCE = 0.001f;
-
-        Math::float2 resultVelocity = 0.0f;
-        for (int i = 0; i < MAX_ITERATIONS; i++)
+        if ((entityFlags & includeFlags) == 0 || (entityFlags & excludeFlags) != 0)
+        {
+            return false;
+        }
+        for (const Entity* ignored : ignoredEntities)
         {
-            CollisionData collisionData = EllipseCast(scene, ellipse, velocity);
-            if (!collisionData.collided)
+            if (ignored == &entity)
             {
-                return resultVelocity + velocity;
+                return false;
             }
+        }
+        return true;
+    }
 
-            Math::float2 movement = Math::Normalize(velocity) * (collisionData.t * Math::Length(velocity) - SMALL_DISTANCE);
-            velocity -= movement;
-            velocity -= collisionData.normal * Math::Dot(velocity, collisionData.normal);
-            resultVelocity += movement;
+    // The spatial grid only holds entities with SpatialGridFlags, other queries walk the flag lists instead
+    static bool CanUseSpatialIndex(const QueryFilter& filter)
+    {
+        return (filter.includeFlags & ~Scene::SpatialGridFlags) == 0;
+    }
 
-            if (!callback(collisionData))
+    // Calls visit(entity) once for every entity the filter accepts that the swept ellipse could hit
+    template<typename F>
+    static void ForEachCandidate(const Scene& scene, const Transform& ellipse, Math::float2 velocity, const QueryFilter& filter, F&& visit)
+    {
+        Span<const uint16_t> flags = scene.GetEntityFlags();
+        if (CanUseSpatialIndex(filter))
+        {
+            // Only entities near the swept ellipse can be hit
+            Math::AABB start = GetEllipseBounds(ellipse);
+            Math::AABB end = { .min = start.min + velocity, .max = start.max + velocity };
+            auto Visit = [&](const Entity* entity)
             {
-                break;
-            }
+                if (filter.Accepts(flags[entity->handle.GetIndex()], *entity))
+                {
+                    visit(entity);
+                }
+            };
+            scene.GetSpatialGrid().Query(Math::Union(start, end), Visit);
+            scene.GetStaticEntities().Query(Math::Union(start, end), Visit);
+            return;
         }
 
-        return resultVelocity;
+        uint16_t remainingFlags = filter.includeFlags;
+        while (remainingFlags != 0)
+        {
+            uint16_t flag = 1 << std::countr_zero(remainingFlags);
+            remainingFlags &= ~flag;
+
+            // Entities with an included flag that was already walked have been visited
+            uint16_t visitedFlags = filter.includeFlags & (flag - 1);
+            for (const Entity* entity : scene.GetEntitiesWithFlag((EntityFlags)flag))
+            {
+                uint16_t entityFlags = flags[entity->handle.GetIndex()];
+                if ((entityFlags & visitedFlags) == 0 && filter.Accepts(entityFlags, *entity))
+                {
+                    visit(entity);
+                }
+            }
+        }
     }
 
-    CollisionData EllipseCast(const Scene& scene, const Transform& ellipse, Math::float2 velocity, uint16_t entityFlags)
+    CollisionData EllipseCast(const Scene& scene, const Transform& ellipse, Math::float2 velocity, const QueryFilter& filter)
     {
         CollisionData minCollision { .collided = false, .t = INFINITY };
-        for (const Entity& entity : scene.entities)
+        auto Register = [&](const CollisionData& collision, const Entity* entity)
         {
-            if ((entity.flags & entityFlags) == 0)
+            if (collision.collided && collision.t < minCollision.t)
             {
-                continue;
+                minCollision = collision;
+                minCollision.entity = entity;
             }
+        };
 
-            CollisionData collision { .collided = false };
-            switch (entity.shape)
+        // Rectangles are gathered and swept a batch at a time, ellipses are cheap enough to test right away
+        RectBatch rects;
+        std::array<const Entity*, RectBatch::Capacity> rectEntities;
+        auto FlushRects = [&]()
+        {
+            size_t hitIndex = 0;
+            CollisionData collision = EllipseRectCollisionBatch(ellipse, velocity, rects, &hitIndex);
+            if (collision.collided)
+            {
+                Register(collision, rectEntities[hitIndex]);
+            }
+            rects.Clear();
+        };
+
+        auto TestEntity = [&](const Entity* entity)
+        {
+            switch (entity->shape)
             {
                 case Shape::Rectangle:
-                    collision = EllipseRectCollision(ellipse, velocity, entity.transform);
+                    rectEntities[rects.count] = entity;
+                    rects.Push(scene.GetColliderGeometry(*entity));
+                    if (rects.IsFull())
+                    {
+                        FlushRects();
+                    }
                     break;
                 case Shape::Ellipse:
-                    collision = CircleCircleCollision(ellipse, velocity, entity.transform);
+                    Register(CircleCircleCollision(ellipse, velocity, scene.GetTransform(*entity)), entity);
                     break;
             }
-            if (!collision.collided)
-            {
-                continue;
-            }
-            if (collision.t < minCollision.t)
-            {
-                minCollision = collision;
-                minCollision.entity = &entity;
-            }
-        }
-        return minCollision;
-    }
-
-    CollisionData CirclePointCollision(Math::float2 circlePosition, Math::float2 velocity, Math::float2 point)
-    {
-        float a = Math::LengthSquared(velocity);
-        float b = Math::Dot(2 * velocity, circlePosition - point);
-        float c = Math::LengthSquared(circlePosition - point) - 1.0f;
+        };
 
-        Math::float2 solutions;
-        if (!Math::SolveQuadratic(a, b, c, solutions))
+        if (!CanUseSpatialIndex(filter))
         {
-            return { .collided = false };
+            ForEachCandidate(scene, ellipse, velocity, filter, TestEntity);
+            FlushRects();
+            return minCollision;
         }
 
-        float t = INFINITY;
-        for (int i = 0; i < 2; i++)
+        Span<const uint16_t> flags = scene.GetEntityFlags();
+        Math::AABB start = GetEllipseBounds(ellipse);
+        Math::AABB end = { .min = start.min + velocity, .max = start.max + velocity };
+        scene.GetSpatialGrid().Query(Math::Union(start, end), [&](const Entity* entity)
         {
-            if (solutions[i] >= 0 && solutions[i] <= 1)
+            if (filter.Accepts(flags[entity->handle.GetIndex()], *entity))
             {
-                t = std::min(t, solutions[i]);
+                TestEntity(entity);
             }
-        }
+        });
+        FlushRects();
 
-        if (t == INFINITY)
+        // Leaves are visited in the order the ellipse's bounds enter them, and skipped once they start past the closest hit
+        scene.GetStaticEntities().Cast(start, velocity, [&](Span<Entity*> leaf)
         {
-            return CollisionData { .collided = false };
-        }
-        assert(t >= 0 && t <= 1);
-        return CollisionData {
-            .collided = true,
-            .contactPoint = point,
-            .normal = Math::Normalize(circlePosition + velocity * t - point),
-            .t = t
-        };
+            for (const Entity* entity : leaf)
+            {
+                if (entity != nullptr && filter.Accepts(flags[entity->handle.GetIndex()], *entity))
+                {
+                    TestEntity(entity);
+                }
+            }
+            FlushRects();
+            return minCollision.t;
+        });
+        return minCollision;
     }
 
-    CollisionData CircleLineCollision(Math::float2 circlePosition, Math::float2 velocity, const Line& line)
+    Array<CollisionData> EllipseCastAll(const Scene& scene, const Transform& ellipse, Math::float2 velocity, const QueryFilter& filter, MemoryArena* arena)
     {
-        Math::float2 edge = line.to - line.from;
-        Math::float2 baseToVertex = line.from - circlePosition;
-
-        float edgeLengthSq = Math::LengthSquared(edge);
-        float edgeDotVelocity = Math::Dot(edge, velocity);
-        float edgeDotBaseToVertex = Math::Dot(edge, baseToVertex);
-
-        float a = edgeLengthSq * -Math::LengthSquared(velocity) + edgeDotVelocity * edgeDotVelocity;
-        float b = edgeLengthSq * 2.0f * Math::Dot(velocity, baseToVertex) - 2.0f * edgeDotVelocity * edgeDotBaseToVertex;
-        float c = edgeLengthSq * (1.0f - Math::LengthSquared(baseToVertex)) + edgeDotBaseToVertex * edgeDotBaseToVertex;
-
-        Math::float2 solutions;
-        if (!Math::SolveQuadratic(a, b, c, solutions))
+        Array<CollisionData> hits;
+        hits.arena = arena;
+        if (filter.maxHits == 0)
         {
-            return { .collided = false };
+            return hits;
         }
 
-        Math::float2 intersectionPoint;
-
-        float t = INFINITY;
-        for (int i = 0; i < 2; i++)
+        // Every hit is needed here rather than the closest of a batch, so this uses the scalar narrowphase
+        ForEachCandidate(scene, ellipse, velocity, filter, [&](const Entity* entity)
         {
-            float f = (edgeDotVelocity * solutions[i] - edgeDotBaseToVertex) / edgeLengthSq;
-            if (solutions[i] >= 0 && solutions[i] <= 1 && f >= 0 && f <= 1 && solutions[i] < t)
+            CollisionData collision { .collided = false };
+            switch (entity->shape)
             {
-                t = solutions[i];
-                intersectionPoint = line.from + f * edge;
+                case Shape::Rectangle:
+                    collision = EllipseRectCollision(ellipse, velocity, scene.GetColliderGeometry(*entity));
+                    break;
+                case Shape::Ellipse:
+                    collision = CircleCircleCollision(ellipse, velocity, scene.GetTransform(*entity));
+                    break;
             }
-        }
-
-        if (t == INFINITY)
-        {
-            return CollisionData { .collided = false };
-        }
-        assert(t >= 0 && t <= 1);
-        return CollisionData {
-            .collided = true,
-            .contactPoint = intersectionPoint,
-            .normal = Math::Normalize(circlePosition - intersectionPoint),
-            .t = t
-        };
-    }
-
-    CollisionData EllipseRectCollision(Transform ellipse, Math::float2 velocity, Transform rect)
-    {
-        ellipse.position /= ellipse.scale;
-        velocity /= ellipse.scale;
-        rect.position /= ellipse.scale;
-        rect.scale /= ellipse.scale;
-
-        Math::Complex rectRotation = Math::Complex::FromAngle(rect.rotation);
-        std::array<Math::float2, 4> corners {
-            rect.position + rectRotation * -rect.scale,
-            rect.position + rectRotation * Math::float2(rect.scale.x, -rect.scale.y),
-            rect.position + rectRotation * rect.scale,
-            rect.position + rectRotation * Math::float2(-rect.scale.x, rect.scale.y)
-        };
-
-        CollisionData minCollision { .collided = false, .t = INFINITY };
-        for (int i = 0; i < (int)corners.size(); i++)
-        {
-            Math::float2 corner = corners[i];
-            Math::float2 nextCorner = corners[(i + 1) % corners.size()];
-
-            CollisionData collision;
-            collision = CirclePointCollision(ellipse.position, velocity, corner);
-            if (collision.collided && collision.t < minCollision.t)
+            if (collision.collided)
             {
-                minCollision = collision;
+                collision.entity = entity;
+                hits.Push(collision);
             }
+        });
 
-            collision = CircleLineCollision(ellipse.position, velocity, Line{ corner, nextCorner });
-            if (collision.collided && collision.t < minCollision.t)
+        // Ties are broken by handle so the order doesn't depend on how the candidates were found
+        std::sort(hits.data, hits.data + hits.size, [](const CollisionData& a, const CollisionData& b)
+        {
+            if (a.t != b.t)
             {
-                minCollision = collision;
+                return a.t < b.t;
             }
+            return a.entity->handle.GetIndex() < b.entity->handle.GetIndex();
+        });
+        if (hits.size > filter.maxHits)
+        {
+            hits.Resize(filter.maxHits);
         }
-
-        minCollision.contactPoint *= ellipse.scale;
-        minCollision.normal = Math::Normalize(minCollision.normal / ellipse.scale);
-
-        return minCollision;
+        return hits;
     }
 
-    CollisionData CircleCircleCollision(const Transform& circle, Math::float2 velocity, const Transform& other)
+    FlagHits EllipseCastPerFlag(const Scene& scene, const Transform& ellipse, Math::float2 velocity, const QueryFilter& filter)
     {
-        const float circleRadius = circle.scale.x;
-        const float otherRadius = other.scale.x;
-
-        float targetDist = circleRadius + otherRadius;
-
-        float a = Math::LengthSquared(velocity);
-        float b = Math::Dot(2 * velocity, circle.position - other.position);
-        float c = Math::LengthSquared(circle.position - other.position) - targetDist * targetDist;
-
-        Math::float2 solutions;
-        if (!Math::SolveQuadratic(a, b, c, solutions))
+        Span<const uint16_t> entityFlags = scene.GetEntityFlags();
+        FlagHits result;
+        for (CollisionData& hit : result.hits)
         {
-            return { .collided = false };
+            hit.t = INFINITY;
         }
 
-        float t = INFINITY;
-        for (int i = 0; i < 2; i++)
+        ForEachCandidate(scene, ellipse, velocity, filter, [&](const Entity* entity)
         {
-            if (solutions[i] >= 0.0f && solutions[i] <= 1.0f)
+            CollisionData collision { .collided = false };
+            switch (entity->shape)
+            {
+                case Shape::Rectangle:
+                    collision = EllipseRectCollision(ellipse, velocity, scene.GetColliderGeometry(*entity));
+                    break;
+                case Shape::Ellipse:
+                    collision = CircleCircleCollision(ellipse, velocity, scene.GetTransform(*entity));
+                    break;
+            }
+            if (!collision.collided)
             {
-                t = std::min(solutions[i], t);
+                return;
             }
-        }
+            collision.entity = entity;
 
-        if (t == INFINITY)
-        {
-            return { .collided = false };
-        }
-
-        Math::float2 normal = Math::Normalize(circle.position + velocity * t - other.position);
-        return CollisionData {
-            .collided = true,
-            .contactPoint = other.position - normal * otherRadius,
-            .normal = normal,
-            .t = t
-        };
+            uint16_t flags = entityFlags[entity->handle.GetIndex()] & filter.includeFlags;
+            while (flags != 0)
+            {
+                int bit = std::countr_zero(flags);
+                flags &= ~(1 << bit);
+                if (collision.t < result.hits[bit].t)
+                {
+                    result.hits[bit] = collision;
+                }
+            }
+        });
+        return result;
     }
 }
@@ -1,26 +1,14 @@
 #pragma once
 
-#include <functional>
+#include <array>
+#include <bit>
+#include <utility>
 
 #include "scene.hpp"
+#include "collision.hpp"
 
 namespace Physics
 {
-    struct CollisionData
-    {
-        bool collided = false;
-        Math::float2 contactPoint = 0.0f;
-        Math::float2 normal = 0.0f;
-        float t = 0.0f;
-        const Entity* entity = nullptr;
-    };
-
-    struct Line
-    {
-        Math::float2 from = 0.0f;
-        Math::float2 to = 0.0f;
-    };
-
     struct GravityZoneInfo
     {
         bool active{};
@@ -31,14 +19,74 @@ namespace Physics
         float radius{};
     };
 
+    /*
+        Decides which entities a physics query tests against:
+        - An entity passes if it has any of includeFlags and none of excludeFlags
+        - Entities in ignoredEntities never pass, such as the entity doing the query
+        - maxHits only limits EllipseCastAll(), which keeps the closest hits
+    */
+    struct QueryFilter
+    {
+        uint16_t includeFlags = (uint16_t)EntityFlags::Collider;
+        uint16_t excludeFlags = 0;
+        Span<const Entity*> ignoredEntities{};
+        size_t maxHits = SIZE_MAX;
+
+        // entityFlags are the entity's flags from Scene::GetEntityFlags()
+        bool Accepts(uint16_t entityFlags, const Entity& entity) const;
+    };
+
+    // Earliest hit for each flag of a EllipseCastPerFlag() query
+    struct FlagHits
+    {
+        std::array<CollisionData, Scene::NumEntityFlags> hits{};
+
+        inline const CollisionData& Get(EntityFlags flag) const
+        {
+            return hits[std::countr_zero((uint16_t)flag)];
+        }
+    };
+
     GravityZoneInfo GetGravity(const Scene& scene, Math::float2 position, Math::float2 currentGravity);
 
-    Math::float2 CollideAndSlide(const Scene& scene, const Transform& ellipse, Math::float2 velocity, std::function<bool(CollisionData)> callback);
+    // Closest hit of the ellipse moving along velocity
+    CollisionData EllipseCast(const Scene& scene, const Transform& ellipse, Math::float2 velocity, const QueryFilter& filter = {});
+
+    // Every entity hit by the ellipse moving along velocity, one hit per entity, sorted by time of impact
+    Array<CollisionData> EllipseCastAll(const Scene& scene, const Transform& ellipse, Math::float2 velocity, const QueryFilter& filter, MemoryArena* arena);
+
+    // Earliest hit for every flag in filter.includeFlags, found with a single walk over the candidates.
+    // An entity with several of the flags counts for each of them, but is only swept once.
+    FlagHits EllipseCastPerFlag(const Scene& scene, const Transform& ellipse, Math::float2 velocity, const QueryFilter& filter);
+
+    // Moves the ellipse along velocity, sliding along every surface it hits, and returns how far it got.
+    // callback(const CollisionData&) is called for each hit and can return false to stop moving.
+    template<typename F>
+    inline Math::float2 CollideAndSlide(const Scene& scene, const Transform& ellipse, Math::float2 velocity, F&& callback, const QueryFilter& filter = {})
+    {
+        constexpr int MAX_ITERATIONS = 5;
+        constexpr float SMALL_DISTANCE = 0.001f;
+
+        Math::float2 resultVelocity = 0.0f;
+        for (int i = 0; i < MAX_ITERATIONS; i++)
+        {
+            CollisionData collisionData = EllipseCast(scene, ellipse, velocity, filter);
+            if (!collisionData.collided)
+            {
+                return resultVelocity + velocity;
+            }
+
+            Math::float2 movement = Math::Normalize(velocity) * (collisionData.t * Math::Length(velocity) - SMALL_DISTANCE);
+            velocity -= movement;
+            velocity -= collisionData.normal * Math::Dot(velocity, collisionData.normal);
+            resultVelocity += movement;
 
-    CollisionData EllipseCast(const Scene& scene, const Transform& ellipse, Math::float2 velocity, uint16_t entityFlags = (uint16_t)EntityFlags::Collider);
+            if (!callback(std::as_const(collisionData)))
+            {
+                break;
+            }
+        }
 
-    CollisionData CirclePointCollision(Math::float2 circlePosition, Math::float2 velocity, Math::float2 point);
-    CollisionData CircleLineCollision(Math::float2 circlePosition, Math::float2 velocity, const Line& line);
-    CollisionData EllipseRectCollision(Transform ellipse, Math::float2 velocity, Transform rect);
-    CollisionData CircleCircleCollision(const Transform& circle, Math::float2 velocity, const Transform& other);
+        return resultVelocity;
+    }
 }
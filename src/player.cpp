@@ -1,23 +1,27 @@
 #include "player.hpp"
 #include "physics.hpp"
+
+#if !HEADLESS
 #include "shader-library.hpp"
 #include "material.hpp"
+#endif
 
 Player::Player(Entity* entity)
     : m_Entity(entity) {}
 
-void Player::Update(const Scene& scene, float cameraRotation, float currentTime, const Input& input, bool* finishedLevel)
+void Player::Update(Scene& scene, float cameraRotation, float currentTime, const Input& input, bool* finishedLevel)
 {
     Math::float2 prevGravityDirection = gravityDirection;
-    Transform prevTransform = m_Entity->transform;
+    Transform transform = scene.GetTransform(*m_Entity);
+    Transform prevTransform = transform;
 
-    Physics::GravityZoneInfo gravityZoneInfo = Physics::GetGravity(scene, m_Entity->transform.position, gravityDirection);
+    Physics::GravityZoneInfo gravityZoneInfo = Physics::GetGravity(scene, transform.position, gravityDirection);
     if (gravityZoneInfo.active)
     {
         gravityDirection = gravityZoneInfo.direction;
     }
     else if (m_PrevGravityZoneInfo.active && m_PrevGravityZoneInfo.shape == Shape::Ellipse &&
-        Math::Distance(m_Entity->transform.position, m_PrevGravityZoneInfo.position) < m_PrevGravityZoneInfo.radius)
+        Math::Distance(transform.position, m_PrevGravityZoneInfo.position) < m_PrevGravityZoneInfo.radius)
     {
         gravityDirection = m_PrevGravityZoneInfo.closestEndDirection;
         m_PrevGravityZoneInfo.active = false;
@@ -70,9 +74,9 @@ void Player::Update(const Scene& scene, float cameraRotation, float currentTime,
         velocity *= drag;
     }
 
-    m_Entity->transform.position += Physics::CollideAndSlide(
-        scene, m_Entity->transform, velocity,
-        [&](Physics::CollisionData collisionData)
+    transform.position += Physics::CollideAndSlide(
+        scene, transform, velocity,
+        [&](const Physics::CollisionData& collisionData)
         {
             velocity -= collisionData.normal * Math::Dot(collisionData.normal, velocity);
             return true;
@@ -107,9 +111,9 @@ void Player::Update(const Scene& scene, float cameraRotation, float currentTime,
     }
 
     m_IsOnGround = false;
-    m_Entity->transform.position += Physics::CollideAndSlide(
-        scene, m_Entity->transform, gravityVelocity,
-        [&](Physics::CollisionData collisionData)
+    transform.position += Physics::CollideAndSlide(
+        scene, transform, gravityVelocity,
+        [&](const Physics::CollisionData& collisionData)
         {
             if (Math::Dot(collisionData.normal, -gravityDirection) >= std::acos(M_PI_4))
             {
@@ -122,9 +126,15 @@ void Player::Update(const Scene& scene, float cameraRotation, float currentTime,
         }
     );
 
-    if (Physics::EllipseCast(scene, prevTransform, m_Entity->transform.position - prevTransform.position, (uint16_t)EntityFlags::DeathZone).collided)
+    // Death zones and checkpoints come out of one sweep of the player's ellipse over this frame's movement
+    Physics::QueryFilter triggerFilter {
+        .includeFlags = (uint16_t)EntityFlags::DeathZone | (uint16_t)EntityFlags::Checkpoint
+    };
+    Physics::FlagHits triggerHits = Physics::EllipseCastPerFlag(scene, prevTransform, transform.position - prevTransform.position, triggerFilter);
+
+    if (triggerHits.Get(EntityFlags::DeathZone).collided)
     {
-        m_Entity->transform.position = spawnPoint;
+        transform.position = spawnPoint;
         velocity = 0.0f;
         gravityVelocity = 0.0f;
         gravityDirection = { 0.0f, -1.0f };
@@ -132,12 +142,12 @@ void Player::Update(const Scene& scene, float cameraRotation, float currentTime,
 
     // TODO: Fix
     /*
-    Physics::CollisionData checkpointCollision = Physics::EllipseCast(scene, prevTransform, m_Entity->transform.position - prevTransform.position, (uint16_t)EntityFlags::Checkpoint);
+    const Physics::CollisionData& checkpointCollision = triggerHits.Get(EntityFlags::Checkpoint);
     if (checkpointCollision.collided && !GetUniform<uint32_t>(checkpointCollision.entity, "started").value_or(1))
     {
         // Cry about it
         Entity* checkpointEntity = const_cast<Entity*>(checkpointCollision.entity);
-        spawnPoint = checkpointEntity->transform.position;
+        spawnPoint = scene.GetTransform(*checkpointEntity).position;
         if (checkpointEntity->shader)
         {
             WriteUniform<uint32_t>(checkpointEntity, "started", 1);
@@ -145,9 +155,11 @@ void Player::Update(const Scene& scene, float cameraRotation, float currentTime,
         }
     }
 
+    // Exits sweep a point rather than the player's ellipse, so they only trigger once the player's center reaches them
     Transform prevTransformPoint = prevTransform;
     prevTransformPoint.scale = 0.001f;
-    Physics::CollisionData exitCollision = Physics::EllipseCast(scene, prevTransformPoint, m_Entity->transform.position - prevTransform.position, (uint16_t)EntityFlags::Exit);
+    Physics::QueryFilter exitFilter { .includeFlags = (uint16_t)EntityFlags::Exit };
+    Physics::CollisionData exitCollision = Physics::EllipseCast(scene, prevTransformPoint, transform.position - prevTransform.position, exitFilter);
     if (exitCollision.collided && !GetUniform<uint32_t>(exitCollision.entity, "started").value_or(1))
     {
         // Cry about it
@@ -161,37 +173,46 @@ void Player::Update(const Scene& scene, float cameraRotation, float currentTime,
     }
     */
 
-    UpdateMaterial(Math::Sign<float>(horizontalInput));
+    UpdateMaterial(Math::Sign<float>(horizontalInput), transform);
+    scene.SetTransform(m_Entity, transform);
+}
+
+Transform Player::GetTransform(const Scene& scene) const
+{
+    return scene.GetTransform(*m_Entity);
 }
 
-void Player::UpdateMaterial(int inputSign)
+void Player::UpdateMaterial(int inputSign, Transform& transform)
 {
     if (m_PrevSign != inputSign && inputSign != 0)
     {
         m_PrevSign = inputSign;
-        m_Entity->transform.scale.x *= -1.0f;
+        transform.scale.x *= -1.0f;
     }
 
+    // Without a renderer there are no materials, only the flip above affects the simulation
+#if !HEADLESS
     Material* material = m_Entity->material;
 
     if (m_LeftEyebrowAngle == 0.0f)
     {
         // TOOD: GetUniform() can return nullptr, which will cause a crash
-        m_LeftEyebrowAngle = *material->GetUniform<float>("left_eyebrow_angle");
-        m_RightEyebrowAngle = *material->GetUniform<float>("right_eyebrow_angle");
-        m_LeftEyebrowHeight = *material->GetUniform<float>("left_eyebrow_height");
-        m_RightEyebrowHeight = *material->GetUniform<float>("right_eyebrow_height");
+        m_LeftEyebrowAngle = *material->GetUniform<float>("left_eyebrow_angle"_id);
+        m_RightEyebrowAngle = *material->GetUniform<float>("right_eyebrow_angle"_id);
+        m_LeftEyebrowHeight = *material->GetUniform<float>("left_eyebrow_height"_id);
+        m_RightEyebrowHeight = *material->GetUniform<float>("right_eyebrow_height"_id);
     }
 
     float speed = Math::Length(velocity);
     float t = 1.0f - std::exp(-10.0f * speed);
 
-    material->SetUniform("left_eyebrow_angle", m_LeftEyebrowAngle * t);
-    material->SetUniform("right_eyebrow_angle", m_RightEyebrowAngle * t);
+    material->SetUniform("left_eyebrow_angle"_id, m_LeftEyebrowAngle * t);
+    material->SetUniform("right_eyebrow_angle"_id, m_RightEyebrowAngle * t);
 
     t = 1.5f - t;
-    material->SetUniform("left_eyebrow_height", m_LeftEyebrowHeight * t);
-    material->SetUniform("right_eyebrow_height", m_RightEyebrowHeight * t);
+    material->SetUniform("left_eyebrow_height"_id, m_LeftEyebrowHeight * t);
+    material->SetUniform("right_eyebrow_height"_id, m_RightEyebrowHeight * t);
+#endif
 }
 
 void Player::Jump()
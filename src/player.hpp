@@ -25,12 +25,10 @@ public:
     Player() = default;
     Player(Entity* entity);
 
-    void Update(const Scene& scene, float cameraRotation, float currentTime, const Input& input, bool* finishedLevel);
+    void Update(Scene& scene, float cameraRotation, float currentTime, const Input& input, bool* finishedLevel);
     void Jump();
 
-    inline Transform& GetTransform() {
-        return m_Entity->transform;
-    }
+    Transform GetTransform(const Scene& scene) const;
 
 private:
     Entity* m_Entity = nullptr;
@@ -53,5 +51,5 @@ private:
     float m_RightEyebrowAngle = 0.0f;
     float m_LeftEyebrowHeight = 0.0f;
     float m_RightEyebrowHeight = 0.0f;
-    void UpdateMaterial(int inputSign);
+    void UpdateMaterial(int inputSign, Transform& transform);
 };
@@ -36,6 +36,10 @@ bool Renderer::Init(SDL_Window* window)
 
     m_Queue = m_Device.getQueue();
 
+    m_RenderPipelineMap.arena = &GlobalArena;
+    m_LightRenderPipelineMap.arena = &GlobalArena;
+    m_EntityDrawData.arena = &GlobalArena;
+
     m_ShaderLibrary.Load(m_Device);
     MaterialManager::Init(m_ShaderLibrary, m_Device);
 
@@ -269,22 +273,39 @@ bool Renderer::Render(const Scene& scene, const Camera& camera)
     m_Queue.writeBuffer(m_TimeBuffer, 0, &m_Time, sizeof(m_Time));
     renderEncoder.setBindGroup(2, m_CameraBindGroup, 0, nullptr);
 
-    for (Entity& entity : scene.entities)
+    // Every entity handle index gets a draw data slot, so lookups below don't need to grow the array
+    while (m_EntityDrawData.size < scene.GetEntityIndexCount())
+    {
+        m_EntityDrawData.Push(DrawData{});
+    }
+
+    // Entities are skipped by their flags alone, and only looked up once they are known to be drawn
+    Span<const uint16_t> flags = scene.GetEntityFlags();
+    Span<const Math::float2> positions = scene.GetPositions();
+    Span<const Math::float2> scales = scene.GetScales();
+    Span<const float> rotations = scene.GetRotations();
+    Span<const uint16_t> zIndices = scene.GetZIndices();
+    uint16_t skipFlags = (uint16_t)EntityFlags::Destroyed;
+    if (!renderHiddenEntities)
+    {
+        skipFlags |= (uint16_t)EntityFlags::Hidden;
+    }
+
+    for (uint32_t index = 0; index < flags.size; index++)
     {
-        if (!renderHiddenEntities && entity.flags & (uint16_t)EntityFlags::Hidden)
+        if ((flags[index] & skipFlags) != 0)
         {
             continue;
         }
+        Entity& entity = *scene.GetEntityAtIndex(index);
 
-        DrawData& drawData = m_EntityDrawData[entity.id];
-        if (drawData.empty)
-        {
-            Log::Debug("Create entity draw data (%)", entity.id);
-            CreateDrawData(drawData);
-        }
+        Transform transform(positions[index], scales[index]);
+        transform.rotation = rotations[index];
+
+        DrawData& drawData = GetDrawData(entity);
         TransformBindGroupData transformData {
-            .transform = entity.transform.GetMatrix(),
-            .zIndex = entity.zIndex
+            .transform = transform.GetMatrix(),
+            .zIndex = zIndices[index]
         };
 
         assert(entity.material != nullptr);
@@ -298,7 +319,7 @@ bool Renderer::Render(const Scene& scene, const Camera& camera)
         renderEncoder.setBindGroup(GROUP_MATERIAL_INDEX, entity.material->bindGroup, 0, nullptr);
         renderEncoder.setBindGroup(GROUP_TRANSFORM_INDEX, drawData.transformBindGroup, 0, nullptr);
 
-        if ((entity.flags & (uint16_t)EntityFlags::Text) != 0)
+        if ((flags[index] & (uint16_t)EntityFlags::Text) != 0)
         {
             // "Ag" is an approximation of the entire alphabet
             float height = m_FontAtlas.MeasureTextHeight("Ag");
@@ -378,22 +399,14 @@ void Renderer::RenderLighting(wgpu::CommandEncoder& commandEncoder, wgpu::Textur
     m_Queue.writeBuffer(m_CameraBuffer, 0, &viewMatrix, sizeof(viewMatrix));
     renderEncoder.setBindGroup(2, m_CameraBindGroup, 0, nullptr);
 
-    for (const Entity& entity : scene.entities)
+    for (const Entity* entityPtr : scene.GetEntitiesWithFlag(EntityFlags::Light))
     {
-        if ((entity.flags & (uint16_t)EntityFlags::Light) == 0)
-        {
-            continue;
-        }
+        const Entity& entity = *entityPtr;
 
-        DrawData& drawData = m_EntityDrawData[entity.id];
-        if (drawData.empty)
-        {
-            Log::Debug("Create entity draw data (%)", entity.id);
-            CreateDrawData(drawData);
-        }
+        DrawData& drawData = GetDrawData(entity);
         TransformBindGroupData transformData {
-            .transform = entity.transform.GetMatrix(),
-            .zIndex = entity.zIndex
+            .transform = scene.GetTransform(entity).GetMatrix(),
+            .zIndex = scene.GetZIndex(entity)
         };
         if (entity.material->updated)
         {
@@ -481,6 +494,10 @@ std::optional<WGPURenderPipeline> Renderer::CreateRenderPipeline(StringView shad
         Log::Error("Shader '%' does not exist.", shaderName);
         return std::nullopt;
     }
+
+    // The entry point and label strings are only needed until the pipeline is created
+    ArenaTemp scratch(&TransientArena);
+
     String vertexEntry;
     vertexEntry.arena = &TransientArena;
     vertexEntry << shaderName << "_vert" << '\0';
@@ -579,12 +596,14 @@ wgpu::RenderPipeline Renderer::GetRenderPipeline(Material* material, wgpu::Textu
     const Shader* shader = material->shader;
     auto& renderPipelineMap = depthStencil ? m_RenderPipelineMap : m_LightRenderPipelineMap;
 
-    auto it = renderPipelineMap.find(shader);
-    if (it != renderPipelineMap.end())
+    wgpu::RenderPipeline* cachedPipeline = renderPipelineMap.Find(shader);
+    if (cachedPipeline != nullptr)
     {
-        return it->second;
+        return *cachedPipeline;
     }
 
+    ArenaTemp scratch(&TransientArena);
+
     String vertexEntry = String::Copy(material->shader->name, &TransientArena) << "_vert";
     vertexEntry.NullTerminate();
     vertexEntry.ReplaceAll('-', '_');
@@ -664,7 +683,7 @@ wgpu::RenderPipeline Renderer::GetRenderPipeline(Material* material, wgpu::Textu
     }
 
     wgpu::RenderPipeline renderPipeline = m_Device.createRenderPipeline(pipelineDescriptor);
-    renderPipelineMap.insert({ shader, renderPipeline });
+    renderPipelineMap.Insert(shader, renderPipeline);
     return renderPipeline;
 }
 
@@ -825,6 +844,17 @@ bool Renderer::LoadDeviceSync()
     return true;
 }
 
+Renderer::DrawData& Renderer::GetDrawData(const Entity& entity)
+{
+    DrawData& drawData = m_EntityDrawData[entity.handle.GetIndex()];
+    if (drawData.empty)
+    {
+        Log::Debug("Create entity draw data (%)", entity.handle.GetIndex());
+        CreateDrawData(drawData);
+    }
+    return drawData;
+}
+
 void Renderer::CreateDrawData(DrawData& drawData)
 {
     assert(drawData.empty);
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <optional>
-#include <unordered_map>
 
 #include <webgpu/webgpu.hpp>
 #include <SDL3/SDL.h>
@@ -69,8 +68,8 @@ private:
 
     wgpu::TextureFormat m_Format = wgpu::TextureFormat::Undefined;
 
-    std::unordered_map<const Shader*, wgpu::RenderPipeline> m_RenderPipelineMap;
-    std::unordered_map<const Shader*, wgpu::RenderPipeline> m_LightRenderPipelineMap;
+    HashMap<const Shader*, wgpu::RenderPipeline> m_RenderPipelineMap;
+    HashMap<const Shader*, wgpu::RenderPipeline> m_LightRenderPipelineMap;
 
     wgpu::RenderPipeline GetRenderPipeline(Material* material, wgpu::TextureFormat textureFormat, bool depthStencil);
 
@@ -105,8 +104,10 @@ private:
         wgpu::Buffer transformBuffer;
         wgpu::BindGroup transformBindGroup;
     };
-    std::unordered_map<uint32_t, DrawData> m_EntityDrawData;
+    // Indexed by EntityHandle::GetIndex(), slots are reused by later entities along with their buffers
+    Array<DrawData> m_EntityDrawData;
 
+    DrawData& GetDrawData(const Entity& entity);
     void CreateDrawData(DrawData& drawData);
 
     wgpu::Buffer m_CameraBuffer;
@@ -4,35 +4,103 @@
 
 #include <cassert>
 
-#include "application.hpp"
 #include "config.hpp"
+#include "memory-arena.hpp"
+
+#if !HEADLESS
 #include "material.hpp"
+#endif
+
+// Remembers where the entity went in positions, indexed by handle index, so RemoveTracked() doesn't have to search
+static void PushTracked(Array<Entity*>& list, Array<uint32_t>& positions, Entity* entity)
+{
+    uint32_t index = entity->handle.GetIndex();
+    while (positions.size <= index)
+    {
+        positions.Push(0);
+    }
+    positions[index] = (uint32_t)list.size;
+    list.Push(entity);
+}
 
-void Scene::Init(MemoryArena* arena)
+// Lists are unordered, so the last entity takes the removed entity's place
+static void RemoveTracked(Array<Entity*>& list, Array<uint32_t>& positions, const Entity* entity)
 {
-    entities.arena = arena;
+    uint32_t position = positions[entity->handle.GetIndex()];
+    assert(position < list.size && list[position] == entity);
+    Entity* last = list[list.size - 1];
+    list[position] = last;
+    positions[last->handle.GetIndex()] = position;
+    list.Pop();
+}
+
+void Scene::Init()
+{
+    // TODO: Is this a good default size?
+    levelArena.Init(256 * 1024, MemoryArenaFlags_ClearToZero | MemoryArenaFlags_VirtualMemory);
+    entities.arena = &levelArena;
+    namePool.arena = &levelArena;
+    handleArena.Init(16 * 1024, MemoryArenaFlags_ClearToZero | MemoryArenaFlags_VirtualMemory);
+    handles.arena = &handleArena;
+    spatialGrid.arena = &levelArena;
+    staticEntities.arena = &levelArena;
+    dynamicEntities.arena = &levelArena;
+    dynamicEntityPositions.arena = &levelArena;
+    gravityZoneGrid.arena = &levelArena;
+    colliderGeometry.arena = &levelArena;
+    ResetEntityData();
+    ResetFlagLists();
 }
 
 Entity* Scene::CreateEntity()
 {
     Entity* entity = entities.Push(Entity{});
-    entity->id = nextId++;
-    entity->zIndex = 100;
+    entity->handle = handles.Create(entity);
+
+    uint32_t index = entity->handle.GetIndex();
+    while (entityFlags.size <= index)
+    {
+        positions.Push(0.0f);
+        scales.Push(1.0f);
+        rotations.Push(0.0f);
+        entityFlags.Push((uint16_t)EntityFlags::Destroyed);
+        zIndices.Push(0);
+    }
+    positions[index] = 0.0f;
+    scales[index] = 1.0f;
+    rotations[index] = 0.0f;
+    entityFlags[index] = 0;
+    zIndices[index] = 100;
+#if !HEADLESS
     entity->material = MaterialManager::GetDefaultMaterial();
+#endif
 
-    // TODO: When entities are destroyed, memory from the named string is not recycled
-    entity->name.arena = &GlobalArena;
-    // TODO: Is this a good default size?
-    entity->name.Reserve(16);
+    // Short names are stored inline, longer ones are given back to the pool when the entity is destroyed
+    entity->name.pool = &namePool;
 
+    PushTracked(dynamicEntities, dynamicEntityPositions, entity);
+    UpdateBounds(entity);
     return entity;
 }
 
 void Scene::DestroyEntity(Entity* entity)
 {
     assert(entity != nullptr);
-    assert((entity->flags & (uint16_t)EntityFlags::Destroyed) == 0);
-    // entity->flags |= (uint16_t)EntityFlags::Destroyed;
+    uint32_t index = entity->handle.GetIndex();
+    assert((entityFlags[index] & (uint16_t)EntityFlags::Destroyed) == 0);
+    RemoveFlags(entity, entityFlags[index]);
+    // Loops over the entity data skip the index until it is handed out again
+    entityFlags[index] = (uint16_t)EntityFlags::Destroyed;
+    if (IsStatic(*entity))
+    {
+        staticEntities.Remove(index);
+    }
+    else
+    {
+        RemoveTracked(dynamicEntities, dynamicEntityPositions, entity);
+    }
+    entity->name.Free();
+    handles.Destroy(entity->handle);
     entities.Erase(entity);
 }
 
@@ -43,8 +111,299 @@ void Scene::EndFrame()
 
 void Scene::Clear()
 {
-    entities.Clear();
-    nextId = 0;
+    // Handles into the previous level become stale rather than resolving to new entities
+    handles.Reset();
+
+    // Everything else owned by the scene lives in the level arena, so there is nothing to free one by one
+    levelArena.Clear();
+    namePool.Reset();
+    entities = IndexedStableArray<Entity>{};
+    entities.arena = &levelArena;
+    ResetEntityData();
+    ResetFlagLists();
+    spatialGrid = SpatialGrid<Entity>{};
+    spatialGrid.arena = &levelArena;
+    staticEntities = Bvh<Entity>{};
+    staticEntities.arena = &levelArena;
+    dynamicEntities = Array<Entity*>{};
+    dynamicEntities.arena = &levelArena;
+    dynamicEntityPositions = Array<uint32_t>{};
+    dynamicEntityPositions.arena = &levelArena;
+    gravityZoneGrid = SpatialGrid<Entity>{};
+    gravityZoneGrid.arena = &levelArena;
+    colliderGeometry = Array<Physics::ColliderGeometry>{};
+    colliderGeometry.arena = &levelArena;
+}
+
+Entity* Scene::GetEntity(EntityHandle handle) const
+{
+    return handles.Get(handle);
+}
+
+Entity* Scene::GetEntityAtIndex(uint32_t index) const
+{
+    return handles.GetAtIndex(index);
+}
+
+size_t Scene::GetEntityIndexCount() const
+{
+    return handles.GetIndexCount();
+}
+
+Transform Scene::GetTransform(const Entity& entity) const
+{
+    uint32_t index = entity.handle.GetIndex();
+    Transform transform(positions[index], scales[index]);
+    transform.rotation = rotations[index];
+    return transform;
+}
+
+void Scene::SetTransform(Entity* entity, const Transform& transform)
+{
+    assert(entity != nullptr);
+    uint32_t index = entity->handle.GetIndex();
+    positions[index] = transform.position;
+    scales[index] = transform.scale;
+    rotations[index] = transform.rotation;
+    UpdateBounds(entity);
+}
+
+uint16_t Scene::GetZIndex(const Entity& entity) const
+{
+    return zIndices[entity.handle.GetIndex()];
+}
+
+void Scene::SetZIndex(Entity* entity, uint16_t zIndex)
+{
+    assert(entity != nullptr);
+    zIndices[entity->handle.GetIndex()] = zIndex;
+}
+
+uint16_t Scene::GetFlags(const Entity& entity) const
+{
+    return entityFlags[entity.handle.GetIndex()];
+}
+
+Span<const Math::float2> Scene::GetPositions() const
+{
+    return { positions.data, positions.size };
+}
+
+Span<const Math::float2> Scene::GetScales() const
+{
+    return { scales.data, scales.size };
+}
+
+Span<const float> Scene::GetRotations() const
+{
+    return { rotations.data, rotations.size };
+}
+
+Span<const uint16_t> Scene::GetEntityFlags() const
+{
+    return { entityFlags.data, entityFlags.size };
+}
+
+Span<const uint16_t> Scene::GetZIndices() const
+{
+    return { zIndices.data, zIndices.size };
+}
+
+// Elliptical gravity zones pull within scale.x of their center whatever scale.y is, the same as ellipse colliders
+static Math::AABB GetGravityZoneBounds(const Transform& transform)
+{
+    return Physics::GetEllipseBounds(transform);
+}
+
+// Keeps the entity in the grid for as long as it has any of the flags in mask
+static void UpdateGridMembership(SpatialGrid<Entity>& grid, uint16_t mask, Entity* entity, uint16_t prevFlags, uint16_t flags, const Math::AABB& bounds)
+{
+    bool wasInGrid = (prevFlags & mask) != 0;
+    bool isInGrid = (flags & mask) != 0;
+    if (!wasInGrid && isInGrid)
+    {
+        grid.Insert(entity->handle.GetIndex(), entity, bounds);
+    }
+    else if (wasInGrid && !isInGrid)
+    {
+        grid.Remove(entity->handle.GetIndex());
+    }
+}
+
+void Scene::SetFlags(Entity* entity, uint16_t flags)
+{
+    assert(entity != nullptr);
+    uint32_t index = entity->handle.GetIndex();
+    uint16_t prevFlags = entityFlags[index];
+
+    uint16_t changedFlags = prevFlags ^ flags;
+    while (changedFlags != 0)
+    {
+        int bit = std::countr_zero(changedFlags);
+        changedFlags &= ~(1 << bit);
+
+        if (flags & (1 << bit))
+        {
+            PushTracked(flagLists[bit], flagListPositions[bit], entity);
+        }
+        else
+        {
+            RemoveTracked(flagLists[bit], flagListPositions[bit], entity);
+        }
+    }
+
+    if (!IsStatic(*entity))
+    {
+        UpdateGridMembership(spatialGrid, SpatialGridFlags, entity, prevFlags, flags, colliderGeometry[index].bounds);
+    }
+    UpdateGridMembership(gravityZoneGrid, (uint16_t)EntityFlags::GravityZone, entity, prevFlags, flags, GetGravityZoneBounds(GetTransform(*entity)));
+
+    entityFlags[index] = flags;
+}
+
+void Scene::UpdateBounds(Entity* entity)
+{
+    assert(entity != nullptr);
+    uint32_t index = entity->handle.GetIndex();
+    while (colliderGeometry.size <= index)
+    {
+        colliderGeometry.Push(Physics::ColliderGeometry{});
+    }
+    Transform transform = GetTransform(*entity);
+    colliderGeometry[index] = Physics::ColliderGeometry::FromTransform(transform);
+    if (entity->shape == Shape::Ellipse)
+    {
+        colliderGeometry[index].bounds = Physics::GetEllipseBounds(transform);
+    }
+    const Math::AABB& bounds = colliderGeometry[index].bounds;
+
+    if (IsStatic(*entity))
+    {
+        // The editor sets the selected entity's transform every frame, so only an actual move makes it dynamic
+        const Math::AABB& staticBounds = staticEntities.GetBounds(index);
+        if (bounds.min.x != staticBounds.min.x || bounds.min.y != staticBounds.min.y ||
+            bounds.max.x != staticBounds.max.x || bounds.max.y != staticBounds.max.y)
+        {
+            MakeDynamic(entity);
+        }
+    }
+    else if ((entityFlags[index] & SpatialGridFlags) != 0)
+    {
+        spatialGrid.Update(index, bounds);
+    }
+    if ((entityFlags[index] & (uint16_t)EntityFlags::GravityZone) != 0)
+    {
+        gravityZoneGrid.Update(index, GetGravityZoneBounds(transform));
+    }
+}
+
+const SpatialGrid<Entity>& Scene::GetGravityZoneGrid() const
+{
+    return gravityZoneGrid;
+}
+
+const Physics::ColliderGeometry& Scene::GetColliderGeometry(const Entity& entity) const
+{
+    const Physics::ColliderGeometry& geometry = colliderGeometry[entity.handle.GetIndex()];
+    assert(geometry.IsBuiltFrom(GetTransform(entity)) && "Collider geometry is out of date with the transform");
+    return geometry;
+}
+
+const SpatialGrid<Entity>& Scene::GetSpatialGrid() const
+{
+    return spatialGrid;
+}
+
+const Bvh<Entity>& Scene::GetStaticEntities() const
+{
+    return staticEntities;
+}
+
+Span<Entity*> Scene::GetDynamicEntities() const
+{
+    return dynamicEntities;
+}
+
+bool Scene::IsStatic(const Entity& entity) const
+{
+    return staticEntities.Contains(entity.handle.GetIndex());
+}
+
+void Scene::BuildStaticEntities()
+{
+    Array<Bvh<Entity>::Item> items;
+    items.arena = &TransientArena;
+    for (Entity& entity : entities)
+    {
+        uint32_t index = entity.handle.GetIndex();
+        if (!IsStatic(entity) && (entityFlags[index] & SpatialGridFlags) != 0)
+        {
+            spatialGrid.Remove(index);
+        }
+        items.Push({ .id = index, .value = &entity, .bounds = colliderGeometry[index].bounds });
+    }
+    dynamicEntities.Resize(0);
+    staticEntities.Build(items);
+}
+
+void Scene::MakeDynamic(Entity* entity)
+{
+    uint32_t index = entity->handle.GetIndex();
+    staticEntities.Remove(index);
+    PushTracked(dynamicEntities, dynamicEntityPositions, entity);
+    if ((entityFlags[index] & SpatialGridFlags) != 0)
+    {
+        spatialGrid.Insert(index, entity, colliderGeometry[index].bounds);
+    }
+}
+
+void Scene::AddFlags(Entity* entity, uint16_t flags)
+{
+    SetFlags(entity, GetFlags(*entity) | flags);
+}
+
+void Scene::RemoveFlags(Entity* entity, uint16_t flags)
+{
+    SetFlags(entity, GetFlags(*entity) & ~flags);
+}
+
+Span<Entity*> Scene::GetEntitiesWithFlag(EntityFlags flag) const
+{
+    assert(std::has_single_bit((uint16_t)flag));
+    return flagLists[std::countr_zero((uint16_t)flag)];
+}
+
+void Scene::ResetFlagLists()
+{
+    for (Array<Entity*>& list : flagLists)
+    {
+        list = Array<Entity*>{};
+        list.arena = &levelArena;
+    }
+    for (Array<uint32_t>& positions : flagListPositions)
+    {
+        positions = Array<uint32_t>{};
+        positions.arena = &levelArena;
+    }
+}
+
+void Scene::ResetEntityData()
+{
+    positions = Array<Math::float2>{};
+    positions.arena = &levelArena;
+    scales = Array<Math::float2>{};
+    scales.arena = &levelArena;
+    rotations = Array<float>{};
+    rotations.arena = &levelArena;
+    entityFlags = Array<uint16_t>{};
+    entityFlags.arena = &levelArena;
+    zIndices = Array<uint16_t>{};
+    zIndices.arena = &levelArena;
+}
+
+const MemoryArena& Scene::GetLevelArena() const
+{
+    return levelArena;
 }
 
 // TODO: Serialize and deserialize Entity::name
@@ -60,25 +419,29 @@ String Scene::Serialize(MemoryArena* arena) const
     // TODO: Automatic unique entity naming scheme
     for (const Entity& entity : entities)
     {
-        if ((entity.flags & (uint16_t)EntityFlags::Player) != 0)
+        uint16_t flags = GetFlags(entity);
+        if ((flags & (uint16_t)EntityFlags::Player) != 0)
         {
             continue;
         }
+        Transform transform = GetTransform(entity);
         out << '[' << entity.name << "]\n";
-        out << "flags = " << entity.flags << '\n';
-        out << "z_index = " << entity.zIndex << '\n';
-        out << "position = [" << entity.transform.position.x << ", " << entity.transform.position.y << "]\n";
-        if (entity.transform.rotation != 0.0f)
+        out << "flags = " << flags << '\n';
+        out << "z_index = " << GetZIndex(entity) << '\n';
+        out << "position = [" << transform.position.x << ", " << transform.position.y << "]\n";
+        if (transform.rotation != 0.0f)
         {
-            out << "rotation = " << entity.transform.rotation << '\n';
+            out << "rotation = " << transform.rotation << '\n';
         }
-        out << "scale = [" << entity.transform.scale.x << ", " << entity.transform.scale.y << "]\n";
+        out << "scale = [" << transform.scale.x << ", " << transform.scale.y << "]\n";
+#if !HEADLESS
         if (entity.material != nullptr)
         {
             out << "material = \"" << entity.material->name << "\"\n";
         }
+#endif
         out << "shape = " << (int)entity.shape << '\n';
-        if (entity.flags & (uint16_t)EntityFlags::GravityZone)
+        if (flags & (uint16_t)EntityFlags::GravityZone)
         {
             out << "gravity_zone = [" << entity.gravityZone.minAngle << ", " << entity.gravityZone.maxAngle << "]\n";
         }
@@ -102,19 +465,24 @@ void Scene::Deserialize(StringView data)
         Config::PushTable(table);
 
         Entity* entity = CreateEntity();
-        entity->name = String::Copy(table, &GlobalArena);
+        entity->name += table;
 
-        entity->flags = Config::Get<int32_t>("flags", 0);
-        entity->zIndex = Config::Get<int32_t>("z_index", 0);
+        SetFlags(entity, Config::Get<int32_t>("flags", 0));
+        SetZIndex(entity, Config::Get<int32_t>("z_index", 0));
 
-        entity->transform.position = Config::Get<Math::float2>("position", 0.0f);
+        Transform transform;
+        transform.position = Config::Get<Math::float2>("position", 0.0f);
         Config::SuppressWarnings(true);
-        entity->transform.rotation = Config::Get<float>("rotation", 0.0f);
+        transform.rotation = Config::Get<float>("rotation", 0.0f);
         Config::SuppressWarnings(false);
-        entity->transform.scale = Config::Get<Math::float2>("scale", 1.0f);
+        transform.scale = Config::Get<Math::float2>("scale", 1.0f);
+        // Ellipse bounds depend on the shape, and BuildStaticEntities() below puts them in the BVH as they are
+        entity->shape = (Shape)Config::Get<int32_t>("shape", (int32_t)Shape::Rectangle);
+        SetTransform(entity, transform);
 
+#if !HEADLESS
         entity->material = MaterialManager::GetMaterial(Config::Get<StringView>("material", ""));
-        entity->shape = (Shape)Config::Get<int32_t>("shape", (int32_t)Shape::Rectangle);
+#endif
 
         Config::SuppressWarnings(true);
         Math::float2 gravityZone = Config::Get<Math::float2>("gravity_zone", 0.0f);
@@ -126,4 +494,6 @@ void Scene::Deserialize(StringView data)
     }
 
     Config::PopTable();
+
+    BuildStaticEntities();
 }
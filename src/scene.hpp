@@ -3,9 +3,13 @@
 #include <vector>
 #include <memory>
 #include <sstream>
+#include <array>
 
 #include "transform.hpp"
+#include "collision.hpp"
 #include "data-structures.hpp"
+#include "spatial-grid.hpp"
+#include "bvh.hpp"
 
 struct Material;
 
@@ -37,13 +41,16 @@ struct GravityZone
     float maxAngle = M_PI;
 };
 
+struct Entity;
+
+// Resolved through Scene::GetEntity(), the index can be used to look entities up in dense side arrays
+using EntityHandle = Handle<Entity>;
+
+// Only what is read once an entity has been picked out, the transform, flags and z-index are kept by Scene
 struct Entity
 {
-    String name;
-    uint16_t id = 1;
-    uint16_t flags = 0;
-    uint16_t zIndex = 0;
-    Transform transform{};
+    SmallString name;
+    EntityHandle handle;
     Material* material = nullptr;
     Shape shape = Shape::Rectangle;
     GravityZone gravityZone{};
@@ -52,7 +59,7 @@ struct Entity
 class Scene
 {
 public:
-    StableArray<Entity> entities;
+    IndexedStableArray<Entity> entities;
 
     struct Properties
     {
@@ -68,18 +75,117 @@ public:
 
     Properties properties;
 
-    void Init(MemoryArena* arena);
+    // Entity storage and names are allocated from the scene's own level arena
+    void Init();
 
     Entity* CreateEntity();
     void DestroyEntity(Entity* entity);
 
+    // Returns nullptr if the entity has been destroyed since the handle was taken
+    Entity* GetEntity(EntityHandle handle) const;
+
+    // Returns nullptr for indices with no live entity
+    Entity* GetEntityAtIndex(uint32_t index) const;
+
+    // Upper bound on the index of any live entity handle, for sizing side arrays
+    size_t GetEntityIndexCount() const;
+
+    Transform GetTransform(const Entity& entity) const;
+    // Also updates the spatial indexes and collider geometry, so they match the new transform
+    void SetTransform(Entity* entity, const Transform& transform);
+
+    uint16_t GetZIndex(const Entity& entity) const;
+    void SetZIndex(Entity* entity, uint16_t zIndex);
+
+    static constexpr size_t NumEntityFlags = sizeof(uint16_t) * 8;
+
+    uint16_t GetFlags(const Entity& entity) const;
+    // Entity flags must be changed through here, so the per-flag entity lists stay up to date
+    void SetFlags(Entity* entity, uint16_t flags);
+    void AddFlags(Entity* entity, uint16_t flags);
+    void RemoveFlags(Entity* entity, uint16_t flags);
+
+    // Entity data read by every physics query and draw, indexed by entity handle index.
+    // Indices with no live entity have the Destroyed flag set, all five spans have the same size.
+    Span<const Math::float2> GetPositions() const;
+    Span<const Math::float2> GetScales() const;
+    Span<const float> GetRotations() const;
+    Span<const uint16_t> GetEntityFlags() const;
+    Span<const uint16_t> GetZIndices() const;
+
+    // All entities with the flag set, in no particular order
+    Span<Entity*> GetEntitiesWithFlag(EntityFlags flag) const;
+
+    /*
+        Entities are indexed by area in one of two places:
+        - Entities loaded by Deserialize() are static, and kept in a BVH built once the level has loaded
+        - Entities created later, or moved since loading, are dynamic. Those with SpatialGridFlags are kept in the spatial grid
+        - Physics casts and editor picking query both, and only visit nearby entities
+    */
+    static constexpr uint16_t SpatialGridFlags = (uint16_t)EntityFlags::Collider | (uint16_t)EntityFlags::Lava |
+        (uint16_t)EntityFlags::DeathZone | (uint16_t)EntityFlags::Checkpoint | (uint16_t)EntityFlags::Exit;
+
+    const SpatialGrid<Entity>& GetSpatialGrid() const;
+    const Bvh<Entity>& GetStaticEntities() const;
+    Span<Entity*> GetDynamicEntities() const;
+    bool IsStatic(const Entity& entity) const;
+
+    // Gravity zones by area, so gravity lookups only visit the zones around the query point
+    const SpatialGrid<Entity>& GetGravityZoneGrid() const;
+
+    // Geometry cached by the last SetTransform() call, physics queries read this instead of the transform
+    const Physics::ColliderGeometry& GetColliderGeometry(const Entity& entity) const;
+
     void EndFrame();
 
     void Clear();
 
+    const MemoryArena& GetLevelArena() const;
+
     String Serialize(MemoryArena* arena) const;
     void Deserialize(StringView data);
 
 private:
-    uint32_t nextId = 0;
+    // Reset wholesale by Clear(), so loading a level never keeps the previous level's memory around
+    MemoryArena levelArena;
+    MemoryPool namePool;
+
+    // Kept out of the level arena, since the slot generations have to outlive Clear() to keep old handles stale
+    MemoryArena handleArena;
+    HandleTable<Entity> handles;
+
+    /*
+        Entity data is split by how often it is read:
+        - Positions, scales, rotations, flags and z-indices each get a contiguous array indexed by entity handle index,
+          so the loops that filter and draw entities only touch the fields they test
+        - Entity keeps the name, material, shape and gravity zone, which are only read for the entities that pass
+        - A destroyed entity's index keeps the Destroyed flag until the index is handed out again
+    */
+    Array<Math::float2> positions;
+    Array<Math::float2> scales;
+    Array<float> rotations;
+    Array<uint16_t> entityFlags;
+    Array<uint16_t> zIndices;
+
+    // Indexed by entity handle index
+    SpatialGrid<Entity> spatialGrid;
+    Bvh<Entity> staticEntities;
+    Array<Entity*> dynamicEntities;
+    Array<uint32_t> dynamicEntityPositions;
+    SpatialGrid<Entity> gravityZoneGrid;
+    Array<Physics::ColliderGeometry> colliderGeometry;
+
+    std::array<Array<Entity*>, NumEntityFlags> flagLists;
+    // Where each entity sits in each flag list, indexed by entity handle index, so removing one is a swap with the last
+    std::array<Array<uint32_t>, NumEntityFlags> flagListPositions;
+
+    void ResetFlagLists();
+    void ResetEntityData();
+
+    // Rebuilds the collider geometry and the entity's spatial index entries from its transform
+    void UpdateBounds(Entity* entity);
+
+    // Rebuilds the static BVH from every entity, so none of them are dynamic afterwards
+    void BuildStaticEntities();
+    void MakeDynamic(Entity* entity);
 };
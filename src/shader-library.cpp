@@ -1,5 +1,6 @@
 #include "shader-library.hpp"
 
+#include <utility>
 #include <variant>
 #include "utility.hpp"
 #include "log.hpp"
@@ -167,6 +168,7 @@ struct Shader::TokenInputStream
 Shader::Shader(wgpu::ShaderModule shaderModule, StringView name, StringView source)
     : name(String::Copy(name, &GlobalArena)), shaderModule(shaderModule)
 {
+    m_UniformMap.arena = &GlobalArena;
     GenerateReflectionInfo(source);
 }
 
@@ -246,13 +248,13 @@ void Shader::ParseMaterialStruct(TokenInputStream& stream)
 
         // TODO: Is there a more elegant way?
         currentDataOffset += (memberAlignment - currentDataOffset % memberAlignment) % memberAlignment;
-        m_UniformMap.insert({
-            String::Copy(memberName, &GlobalArena),
+        m_UniformMap.Insert(
+            StringId::Intern(memberName),
             UniformData {
                 .offset = currentDataOffset,
                 .dataType = dataType
             }
-        });
+        );
         currentDataOffset += memberSize;
     }
 }
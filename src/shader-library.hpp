@@ -6,6 +6,7 @@
 
 #include "log.hpp"
 #include "data-structures.hpp"
+#include "string-id.hpp"
 
 class Shader
 {
@@ -60,7 +61,7 @@ public:
         uint8_t offset{};
     };
 
-    std::unordered_map<StringView, UniformData> m_UniformMap;
+    HashMap<StringId, UniformData> m_UniformMap;
 
 private:
     struct TokenInputStream;
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define SIMD_SSE 1
+    #include <emmintrin.h>
+#else
+    #define SIMD_SSE 0
+#endif
+
+/*
+    Four float lanes, backed by SSE where it is available:
+    - Without SSE every operation is a plain loop over the lanes, which compilers vectorize where they can
+    - Comparisons return a Mask4, use Select() instead of branching on lanes
+*/
+
+namespace Simd
+{
+    struct Mask4
+    {
+#if SIMD_SSE
+        __m128 v;
+#else
+        uint32_t v[4];
+#endif
+
+        inline Mask4 operator&(Mask4 other) const
+        {
+#if SIMD_SSE
+            return { _mm_and_ps(v, other.v) };
+#else
+            return { { v[0] & other.v[0], v[1] & other.v[1], v[2] & other.v[2], v[3] & other.v[3] } };
+#endif
+        }
+
+        // One bit per lane, lane 0 in the lowest bit
+        inline int GetBits() const
+        {
+#if SIMD_SSE
+            return _mm_movemask_ps(v);
+#else
+            return (v[0] & 1) | ((v[1] & 1) << 1) | ((v[2] & 1) << 2) | ((v[3] & 1) << 3);
+#endif
+        }
+    };
+
+    struct Float4
+    {
+#if SIMD_SSE
+        __m128 v;
+#else
+        float v[4];
+#endif
+
+        static inline Float4 Broadcast(float value)
+        {
+#if SIMD_SSE
+            return { _mm_set1_ps(value) };
+#else
+            return { { value, value, value, value } };
+#endif
+        }
+
+        static inline Float4 Load(const float* data)
+        {
+#if SIMD_SSE
+            return { _mm_loadu_ps(data) };
+#else
+            Float4 result;
+            memcpy(result.v, data, sizeof(result.v));
+            return result;
+#endif
+        }
+
+        inline void Store(float* data) const
+        {
+#if SIMD_SSE
+            _mm_storeu_ps(data, v);
+#else
+            memcpy(data, v, sizeof(v));
+#endif
+        }
+
+#if SIMD_SSE
+    #define SIMD_FLOAT4_OPERATOR(op, intrinsic) \
+        inline Float4 operator op(Float4 other) const { return { intrinsic(v, other.v) }; }
+    #define SIMD_MASK4_OPERATOR(op, intrinsic) \
+        inline Mask4 operator op(Float4 other) const { return { intrinsic(v, other.v) }; }
+#else
+    #define SIMD_FLOAT4_OPERATOR(op, intrinsic) \
+        inline Float4 operator op(Float4 other) const \
+        { \
+            return { { v[0] op other.v[0], v[1] op other.v[1], v[2] op other.v[2], v[3] op other.v[3] } }; \
+        }
+    #define SIMD_MASK4_OPERATOR(op, intrinsic) \
+        inline Mask4 operator op(Float4 other) const \
+        { \
+            Mask4 result; \
+            for (int i = 0; i < 4; i++) result.v[i] = v[i] op other.v[i] ? UINT32_MAX : 0; \
+            return result; \
+        }
+#endif
+
+        SIMD_FLOAT4_OPERATOR(+, _mm_add_ps)
+        SIMD_FLOAT4_OPERATOR(-, _mm_sub_ps)
+        SIMD_FLOAT4_OPERATOR(*, _mm_mul_ps)
+        SIMD_FLOAT4_OPERATOR(/, _mm_div_ps)
+
+        SIMD_MASK4_OPERATOR(<, _mm_cmplt_ps)
+        SIMD_MASK4_OPERATOR(<=, _mm_cmple_ps)
+        SIMD_MASK4_OPERATOR(>, _mm_cmpgt_ps)
+        SIMD_MASK4_OPERATOR(>=, _mm_cmpge_ps)
+
+    #undef SIMD_FLOAT4_OPERATOR
+    #undef SIMD_MASK4_OPERATOR
+
+        inline Float4 operator-() const
+        {
+            return *this * Broadcast(-1.0f);
+        }
+    };
+
+    inline Float4 Sqrt(Float4 value)
+    {
+#if SIMD_SSE
+        return { _mm_sqrt_ps(value.v) };
+#else
+        return { { std::sqrt(value.v[0]), std::sqrt(value.v[1]), std::sqrt(value.v[2]), std::sqrt(value.v[3]) } };
+#endif
+    }
+
+    // Picks ifTrue in the lanes where mask is set
+    inline Float4 Select(Mask4 mask, Float4 ifTrue, Float4 ifFalse)
+    {
+#if SIMD_SSE
+        return { _mm_or_ps(_mm_and_ps(mask.v, ifTrue.v), _mm_andnot_ps(mask.v, ifFalse.v)) };
+#else
+        Float4 result;
+        for (int i = 0; i < 4; i++)
+        {
+            result.v[i] = mask.v[i] ? ifTrue.v[i] : ifFalse.v[i];
+        }
+        return result;
+#endif
+    }
+}
@@ -0,0 +1,38 @@
+#include "simulation.hpp"
+
+namespace Simulation
+{
+    Entity* SpawnPlayer(Scene& scene)
+    {
+        Entity* playerEntity = scene.CreateEntity();
+        playerEntity->shape = Shape::Ellipse;
+        scene.SetTransform(playerEntity, Transform(Math::float2(0.0f, 0.0f), Math::float2(0.1)));
+        scene.AddFlags(playerEntity, (uint16_t)EntityFlags::Player);
+        return playerEntity;
+    }
+
+    bool Step(Scene& scene, Player& player, Camera& camera, const Input& input, float currentTime)
+    {
+        bool finishedLevel = false;
+        player.Update(scene, camera.transform.rotation, currentTime, input, &finishedLevel);
+
+        Math::float2 down = scene.properties.flags & (uint32_t)Scene::Properties::Flags::LockCameraRotation ?
+            Math::float2(0, -1) : player.gravityDirection;
+
+        Math::float2 right = scene.properties.flags & (uint32_t)Scene::Properties::Flags::LockCameraRotation ?
+            Math::float2(1, 0) : Math::float2{ -player.gravityDirection.y, player.gravityDirection.x };
+
+        Math::float2 cameraOffset = { 0.0f, 0.3f };
+        cameraOffset.x = (std::exp(Math::Dot(player.velocity, right)) - 1.0f) * 20.0f;
+        camera.FollowPlayer(player.GetTransform(scene).position, cameraOffset, down, TimeStep);
+        if (scene.properties.flags & (uint32_t)Scene::Properties::Flags::LockCameraY)
+        {
+            camera.transform.position.y = 0.0f;
+        }
+        if (scene.properties.flags & (uint32_t)Scene::Properties::Flags::LockCameraRotation)
+        {
+            camera.transform.rotation = 0.0f;
+        }
+        return finishedLevel;
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "camera.hpp"
+#include "input.hpp"
+#include "player.hpp"
+#include "scene.hpp"
+
+/*
+    One fixed step of gameplay, without anything that needs a window or a GPU:
+    - Application::LoopGame() and the headless simulate tool both step through here, so they can't drift apart
+    - The camera is part of the step, because the player's controls are relative to the camera rotation
+*/
+
+namespace Simulation
+{
+    constexpr float TimeStep = 1.0f / 60.0f;
+
+    // Creates the player's entity at the origin. Materials are left to the caller, since they need the renderer
+    Entity* SpawnPlayer(Scene& scene);
+
+    // Returns true on the step the player finishes the level
+    bool Step(Scene& scene, Player& player, Camera& camera, const Input& input, float currentTime);
+}
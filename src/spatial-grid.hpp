@@ -0,0 +1,299 @@
+#pragma once
+
+#include "data-structures.hpp"
+#include "math.hpp"
+
+/*
+    A spatial hash of axis aligned bounding boxes over an unbounded uniform grid:
+    - Items are identified by a dense id, such as EntityHandle::GetIndex(), which indexes the item array directly
+    - Each occupied cell has a linked list of nodes, one per item overlapping the cell
+    - Items covering more than MaxCellsPerItem cells go in a separate list that every query visits
+    - Query() calls back once per item whose cells overlap the bounds, callers still have to do their own exact tests
+    - Queries are not thread safe, since they stamp visited items to skip duplicates
+*/
+
+template<typename T>
+struct SpatialGrid
+{
+    static constexpr int32_t MaxCellsPerItem = 64;
+    static constexpr uint32_t NullNode = UINT32_MAX;
+
+    MemoryArena* arena = nullptr;
+
+    float cellSize = 1.0f;
+
+    struct CellRange
+    {
+        int32_t minX = 0;
+        int32_t minY = 0;
+        int32_t maxX = -1;
+        int32_t maxY = -1;
+
+        inline bool operator==(const CellRange& other) const = default;
+
+        inline int64_t GetCellCount() const
+        {
+            return (int64_t)(maxX - minX + 1) * (maxY - minY + 1);
+        }
+    };
+
+    struct Item
+    {
+        T* value = nullptr;
+        CellRange cells;
+        bool inserted = false;
+        bool oversized = false;
+    };
+
+    struct Node
+    {
+        uint32_t item = 0;
+        uint32_t next = NullNode;
+    };
+
+    Array<Item> items;
+    Array<Node> nodes;
+    Array<uint32_t> freeNodes;
+    Array<uint32_t> oversizedItems;
+
+    // First node of every occupied cell
+    HashMap<uint64_t, uint32_t> cells;
+
+    mutable Array<uint32_t> queryStamps;
+    mutable uint32_t queryStamp = 0;
+
+    size_t size = 0;
+
+    inline void Insert(uint32_t id, T* value, const Math::AABB& bounds)
+    {
+        SetArenas();
+        while (items.size <= id)
+        {
+            items.Push(Item{});
+            queryStamps.Push(0);
+        }
+
+        Item& item = items[id];
+        assert(!item.inserted);
+        item.value = value;
+        item.cells = GetCellRange(bounds);
+        item.inserted = true;
+        item.oversized = item.cells.GetCellCount() > MaxCellsPerItem;
+        size++;
+
+        if (item.oversized)
+        {
+            oversizedItems.Push(id);
+            return;
+        }
+        for (int32_t y = item.cells.minY; y <= item.cells.maxY; y++)
+        {
+            for (int32_t x = item.cells.minX; x <= item.cells.maxX; x++)
+            {
+                uint64_t key = GetCellKey(x, y);
+                uint32_t* head = cells.Find(key);
+                if (head == nullptr)
+                {
+                    head = cells.Insert(key, NullNode);
+                }
+                uint32_t node = AllocateNode();
+                nodes[node] = Node{ .item = id, .next = *head };
+                *head = node;
+            }
+        }
+    }
+
+    inline void Remove(uint32_t id)
+    {
+        assert(Contains(id));
+        Item& item = items[id];
+        item.inserted = false;
+        size--;
+
+        if (item.oversized)
+        {
+            for (size_t i = 0; i < oversizedItems.size; i++)
+            {
+                if (oversizedItems[i] == id)
+                {
+                    oversizedItems[i] = oversizedItems[oversizedItems.size - 1];
+                    oversizedItems.Pop();
+                    break;
+                }
+            }
+            return;
+        }
+        for (int32_t y = item.cells.minY; y <= item.cells.maxY; y++)
+        {
+            for (int32_t x = item.cells.minX; x <= item.cells.maxX; x++)
+            {
+                uint64_t key = GetCellKey(x, y);
+                uint32_t* head = cells.Find(key);
+                assert(head != nullptr);
+
+                uint32_t* link = head;
+                while (nodes[*link].item != id)
+                {
+                    link = &nodes[*link].next;
+                    assert(*link != NullNode);
+                }
+                uint32_t node = *link;
+                *link = nodes[node].next;
+                freeNodes.Push(node);
+
+                if (*head == NullNode)
+                {
+                    cells.Erase(key);
+                }
+            }
+        }
+    }
+
+    // Only touches the cells if the item moved into a different set of them
+    inline void Update(uint32_t id, const Math::AABB& bounds)
+    {
+        assert(Contains(id));
+        if (items[id].cells == GetCellRange(bounds))
+        {
+            return;
+        }
+        T* value = items[id].value;
+        Remove(id);
+        Insert(id, value, bounds);
+    }
+
+    inline bool Contains(uint32_t id) const
+    {
+        return id < items.size && items[id].inserted;
+    }
+
+    template<typename F>
+    inline void Query(const Math::AABB& bounds, F&& callback) const
+    {
+        if (size == 0)
+        {
+            return;
+        }
+        NextQueryStamp();
+
+        for (uint32_t id : oversizedItems)
+        {
+            callback(items[id].value);
+        }
+
+        CellRange range = GetCellRange(bounds);
+        if (range.GetCellCount() > (int64_t)cells.size)
+        {
+            // Cheaper to walk the occupied cells than every cell in the range
+            for (const auto& [key, head] : cells)
+            {
+                int32_t x = (int32_t)(key >> 32);
+                int32_t y = (int32_t)(uint32_t)key;
+                if (x >= range.minX && x <= range.maxX && y >= range.minY && y <= range.maxY)
+                {
+                    VisitCell(head, callback);
+                }
+            }
+            return;
+        }
+        for (int32_t y = range.minY; y <= range.maxY; y++)
+        {
+            for (int32_t x = range.minX; x <= range.maxX; x++)
+            {
+                const uint32_t* head = cells.Find(GetCellKey(x, y));
+                if (head != nullptr)
+                {
+                    VisitCell(*head, callback);
+                }
+            }
+        }
+    }
+
+    // Keeps the memory of the arrays around
+    inline void Clear()
+    {
+        items.Resize(0);
+        nodes.Resize(0);
+        freeNodes.Resize(0);
+        oversizedItems.Resize(0);
+        queryStamps.Resize(0);
+        cells.Clear();
+        queryStamp = 0;
+        size = 0;
+    }
+
+private:
+    inline void SetArenas()
+    {
+        items.arena = arena;
+        nodes.arena = arena;
+        freeNodes.arena = arena;
+        oversizedItems.arena = arena;
+        queryStamps.arena = arena;
+        cells.arena = arena;
+    }
+
+    inline CellRange GetCellRange(const Math::AABB& bounds) const
+    {
+        return {
+            .minX = GetCell(bounds.min.x),
+            .minY = GetCell(bounds.min.y),
+            .maxX = GetCell(bounds.max.x),
+            .maxY = GetCell(bounds.max.y)
+        };
+    }
+
+    inline int32_t GetCell(float coordinate) const
+    {
+        // Clamped so far away or NaN coordinates can't overflow the cell index
+        constexpr float Limit = 1 << 30;
+        float cell = std::floor(coordinate / cellSize);
+        return (int32_t)Math::Min(Math::Max(cell, -Limit), Limit);
+    }
+
+    static inline uint64_t GetCellKey(int32_t x, int32_t y)
+    {
+        return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+    }
+
+    inline uint32_t AllocateNode()
+    {
+        if (freeNodes.size > 0)
+        {
+            uint32_t node = freeNodes[freeNodes.size - 1];
+            freeNodes.Pop();
+            return node;
+        }
+        nodes.Push(Node{});
+        return nodes.size - 1;
+    }
+
+    inline void NextQueryStamp() const
+    {
+        queryStamp++;
+        if (queryStamp == 0)
+        {
+            // Stamps wrapped around, old stamps could collide with new ones
+            for (uint32_t& stamp : queryStamps)
+            {
+                stamp = 0;
+            }
+            queryStamp = 1;
+        }
+    }
+
+    template<typename F>
+    inline void VisitCell(uint32_t node, F& callback) const
+    {
+        for (; node != NullNode; node = nodes[node].next)
+        {
+            uint32_t id = nodes[node].item;
+            if (queryStamps[id] == queryStamp)
+            {
+                continue;
+            }
+            queryStamps[id] = queryStamp;
+            callback(items[id].value);
+        }
+    }
+};
@@ -0,0 +1,33 @@
+#include "string-id.hpp"
+
+#include <cassert>
+
+static MemoryArena s_Arena;
+static HashMap<StringId, StringView> s_StringMap;
+
+StringView StringId::GetString() const
+{
+    StringView* str = s_StringMap.Find(*this);
+    return str != nullptr ? *str : StringView();
+}
+
+StringId StringId::Intern(StringView str)
+{
+    StringId id(str);
+
+    StringView* existing = s_StringMap.Find(id);
+    if (existing != nullptr)
+    {
+        assert(existing->Equals(str) && "StringId collision");
+        return id;
+    }
+
+    if (s_Arena.data == nullptr)
+    {
+        // TODO: Is this a good default size?
+        s_Arena.Init(16 * 1024, MemoryArenaFlags_ClearToZero);
+        s_StringMap.arena = &s_Arena;
+    }
+    s_StringMap.Insert(id, String::Copy(str, &s_Arena));
+    return id;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "data-structures.hpp"
+
+/*
+    A 32-bit identifier for a string:
+    - The id is a hash of the string, so "name"_id is computed at compile time
+    - Intern() remembers the string behind an id, so it can still be printed or serialized
+    - Interning two different strings with the same id is an error
+*/
+
+struct StringId
+{
+    uint32_t value = 0;
+
+    constexpr StringId() = default;
+    explicit constexpr StringId(StringView str)
+    {
+        uint64_t hash = HashString(str);
+        value = (uint32_t)(hash ^ (hash >> 32));
+    }
+
+    constexpr bool operator==(const StringId& other) const = default;
+
+    constexpr uint64_t GetHash() const
+    {
+        return HashInteger(value);
+    }
+
+    // Returns an empty view if the string was never interned
+    StringView GetString() const;
+
+    static StringId Intern(StringView str);
+};
+
+consteval StringId operator""_id(const char* str, size_t length)
+{
+    return StringId(StringView(str, length));
+}
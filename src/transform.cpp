@@ -9,3 +9,13 @@ Math::Matrix3x3 Transform::GetMatrix() const
         Math::float3( position.x,             position.y,            1 )
     );
 }
+
+Math::AABB Transform::GetBounds() const
+{
+    Math::float2 direction = Math::Direction(rotation);
+    Math::float2 extent = {
+        std::abs(direction.x * scale.x) + std::abs(direction.y * scale.y),
+        std::abs(direction.y * scale.x) + std::abs(direction.x * scale.y)
+    };
+    return { .min = position - extent, .max = position + extent };
+}
@@ -13,4 +13,7 @@ struct Transform
         : position(position), scale(scale) {}
 
     Math::Matrix3x3 GetMatrix() const;
+
+    // Bounds of the rotated rectangle spanned by scale, which also contain an ellipse with the same transform
+    Math::AABB GetBounds() const;
 };
@@ -3,7 +3,7 @@
 #include <SDL3/SDL.h>
 #include <cassert>
 #include "log.hpp"
-#include "application.hpp"
+#include "memory-arena.hpp"
 
 #if __APPLE__
     #include <unistd.h>
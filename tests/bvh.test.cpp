@@ -0,0 +1,164 @@
+#include "bvh.hpp"
+#include <doctest.h>
+#include <random>
+#include <set>
+
+TEST_CASE("Bvh")
+{
+    MemoryArena arena;
+    arena.Init(1024, MemoryArenaFlags_ClearToZero);
+
+    Bvh<int> bvh;
+    bvh.arena = &arena;
+
+    constexpr int ItemCount = 2000;
+    int values[ItemCount];
+    Math::AABB bounds[ItemCount];
+    bool inserted[ItemCount] = {};
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> extent(0.01f, 3.0f);
+    auto RandomBounds = [&]
+    {
+        Math::float2 center = { position(rng), position(rng) };
+        Math::float2 halfSize = { extent(rng), extent(rng) };
+        return Math::AABB{
+            .min = { center.x - halfSize.x, center.y - halfSize.y },
+            .max = { center.x + halfSize.x, center.y + halfSize.y }
+        };
+    };
+
+    Array<Bvh<int>::Item> items;
+    items.arena = &arena;
+    for (int i = 0; i < ItemCount; i++)
+    {
+        values[i] = i;
+        bounds[i] = RandomBounds();
+        // Stacks of identical boxes can't be split by the heuristic
+        if (i % 100 < 20)
+        {
+            bounds[i] = bounds[i - i % 100];
+        }
+        items.Push({ .id = (uint32_t)i, .value = &values[i], .bounds = bounds[i] });
+        inserted[i] = true;
+    }
+    bvh.Build(items);
+    CHECK(bvh.size == ItemCount);
+
+    for (int i = 0; i < ItemCount; i += 7)
+    {
+        bvh.Remove(i);
+        inserted[i] = false;
+    }
+    CHECK(bvh.Contains(1));
+    CHECK(!bvh.Contains(7));
+    CHECK(bvh.GetBounds(1).min.x == bounds[1].min.x);
+
+    for (int query = 0; query < 200; query++)
+    {
+        Math::AABB queryBounds = RandomBounds();
+
+        std::set<int> found;
+        bvh.Query(queryBounds, [&](int* value)
+        {
+            CHECK(found.insert(*value).second);
+        });
+
+        // Unlike the spatial grid, the item bounds are tested exactly
+        for (int i = 0; i < ItemCount; i++)
+        {
+            CHECK(found.contains(i) == (inserted[i] && Math::Overlaps(bounds[i], queryBounds)));
+        }
+    }
+
+    // A box swept along velocity overlaps an item if the item grown by the box's half size is entered for t in [0, 1]
+    auto SweptOverlapTime = [](const Math::AABB& item, const Math::AABB& box, Math::float2 velocity, float& time)
+    {
+        float tMin = 0.0f, tMax = 1.0f;
+        float o[2] = { (box.min.x + box.max.x) * 0.5f, (box.min.y + box.max.y) * 0.5f };
+        float half[2] = { (box.max.x - box.min.x) * 0.5f, (box.max.y - box.min.y) * 0.5f };
+        float min[2] = { item.min.x - half[0], item.min.y - half[1] };
+        float max[2] = { item.max.x + half[0], item.max.y + half[1] };
+        float v[2] = { velocity.x, velocity.y };
+        for (int axis = 0; axis < 2; axis++)
+        {
+            float t0 = (min[axis] - o[axis]) / v[axis];
+            float t1 = (max[axis] - o[axis]) / v[axis];
+            tMin = std::max(tMin, std::min(t0, t1));
+            tMax = std::min(tMax, std::max(t0, t1));
+        }
+        time = tMin;
+        return tMin <= tMax;
+    };
+
+    for (int cast = 0; cast < 200; cast++)
+    {
+        Math::AABB box = RandomBounds();
+        Math::float2 velocity = { position(rng), position(rng) };
+
+        // Without early outs every item the box sweeps over is visited, nearest leaves first
+        std::set<int> visited;
+        bvh.Cast(box, velocity, [&](Span<int*> leaf)
+        {
+            for (int* value : leaf)
+            {
+                if (value != nullptr)
+                {
+                    CHECK(visited.insert(*value).second);
+                }
+            }
+            return 1.0f;
+        });
+
+        float closestTime = INFINITY;
+        int closest = -1;
+        for (int i = 0; i < ItemCount; i++)
+        {
+            float time;
+            if (inserted[i] && SweptOverlapTime(bounds[i], box, velocity, time))
+            {
+                CHECK(visited.contains(i));
+                if (time < closestTime)
+                {
+                    closestTime = time;
+                    closest = i;
+                }
+            }
+            if (!inserted[i])
+            {
+                CHECK(!visited.contains(i));
+            }
+        }
+
+        // Returning the closest time found so far still finds the closest item
+        float foundTime = INFINITY;
+        bvh.Cast(box, velocity, [&](Span<int*> leaf)
+        {
+            for (int* value : leaf)
+            {
+                float time;
+                if (value != nullptr && SweptOverlapTime(bounds[*value], box, velocity, time) && time < foundTime)
+                {
+                    foundTime = time;
+                }
+            }
+            return foundTime;
+        });
+        if (closest >= 0)
+        {
+            CHECK(foundTime == closestTime);
+        }
+        else
+        {
+            CHECK(foundTime == INFINITY);
+        }
+    }
+
+    bvh.Clear();
+    int visitedCount = 0;
+    bvh.Query({ .min = { -200.0f, -200.0f }, .max = { 200.0f, 200.0f } }, [&](int*) { visitedCount++; });
+    CHECK(visitedCount == 0);
+
+    arena.Free();
+}
@@ -0,0 +1,149 @@
+#include "collision.hpp"
+#include "bvh.hpp"
+#include "spatial-grid.hpp"
+#include <doctest.h>
+#include <random>
+
+TEST_CASE("Ellipse Rect Collision Batch")
+{
+    using namespace Physics;
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(-5.0f, 5.0f);
+    std::uniform_real_distribution<float> scale(0.1f, 2.0f);
+    std::uniform_real_distribution<float> angle(-3.14159f, 3.14159f);
+
+    auto Close = [](Math::float2 a, Math::float2 b)
+    {
+        return std::abs(a.x - b.x) < 1e-3f && std::abs(a.y - b.y) < 1e-3f;
+    };
+
+    RectBatch rects;
+    Transform transforms[RectBatch::Capacity];
+    int hitCount = 0;
+    for (int iteration = 0; iteration < 500; iteration++)
+    {
+        Transform ellipse(Math::float2(position(rng), position(rng)), Math::float2(scale(rng), scale(rng)));
+        Math::float2 velocity = Math::float2(position(rng), position(rng));
+
+        // Covers full groups of four as well as a partial last group
+        rects.Clear();
+        size_t count = 1 + rng() % RectBatch::Capacity;
+        for (size_t i = 0; i < count; i++)
+        {
+            transforms[i] = Transform(Math::float2(position(rng), position(rng)), Math::float2(scale(rng), scale(rng)));
+            transforms[i].rotation = angle(rng);
+            rects.Push(ColliderGeometry::FromTransform(transforms[i]));
+        }
+
+        CollisionData expected { .collided = false, .t = INFINITY };
+        size_t expectedIndex = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            CollisionData collision = EllipseRectCollision(ellipse, velocity, transforms[i]);
+            if (collision.collided && collision.t < expected.t)
+            {
+                expected = collision;
+                expectedIndex = i;
+            }
+        }
+
+        size_t hitIndex = SIZE_MAX;
+        CollisionData result = EllipseRectCollisionBatch(ellipse, velocity, rects, &hitIndex);
+
+        REQUIRE(result.collided == expected.collided);
+        if (!expected.collided)
+        {
+            CHECK(hitIndex == SIZE_MAX);
+            continue;
+        }
+        hitCount++;
+        CHECK(hitIndex == expectedIndex);
+        CHECK(result.t == doctest::Approx(expected.t).epsilon(1e-4));
+        CHECK(Close(result.contactPoint, expected.contactPoint));
+        CHECK(Close(result.normal, expected.normal));
+    }
+    // Make sure the random scenes actually exercise hits
+    CHECK(hitCount > 100);
+
+    rects.Clear();
+    CHECK(!EllipseRectCollisionBatch(Transform(0.0f, 1.0f), 1.0f, rects).collided);
+}
+
+TEST_CASE("Collider Geometry")
+{
+    using namespace Physics;
+
+    Transform transform(Math::float2(1.0f, 2.0f), Math::float2(3.0f, 1.0f));
+    transform.rotation = Math::PI / 2.0f;
+    ColliderGeometry geometry = ColliderGeometry::FromTransform(transform);
+
+    // A quarter turn maps the local (-3, -1) corner to (1, -3) around the position
+    CHECK(geometry.corners[0].x == doctest::Approx(2.0f));
+    CHECK(geometry.corners[0].y == doctest::Approx(-1.0f));
+    CHECK(geometry.corners[2].x == doctest::Approx(0.0f));
+    CHECK(geometry.corners[2].y == doctest::Approx(5.0f));
+    CHECK(geometry.bounds.min.x == doctest::Approx(0.0f));
+    CHECK(geometry.bounds.max.y == doctest::Approx(5.0f));
+    CHECK(geometry.downDirection.x == doctest::Approx(1.0f));
+
+    CHECK(geometry.IsBuiltFrom(transform));
+    transform.position.x += 0.5f;
+    CHECK(!geometry.IsBuiltFrom(transform));
+}
+
+TEST_CASE("Ellipse Bounds")
+{
+    using namespace Physics;
+
+    MemoryArena arena;
+    arena.Init(1024, MemoryArenaFlags_ClearToZero);
+
+    // Flatter than it is wide, but swept as a circle of radius scale.x
+    Transform collider(Math::float2(0.0f, 0.0f), Math::float2(2.0f, 0.25f));
+    Transform ellipse(Math::float2(0.0f, 3.0f), Math::float2(0.5f, 0.5f));
+    Math::float2 velocity(0.0f, -2.0f);
+
+    CollisionData collision = CircleCircleCollision(ellipse, velocity, collider);
+    REQUIRE(collision.collided);
+    CHECK(collision.t == doctest::Approx(0.25f));
+
+    Math::AABB bounds = GetEllipseBounds(collider);
+    CHECK(bounds.min.x == doctest::Approx(-2.0f));
+    CHECK(bounds.min.y == doctest::Approx(-2.0f));
+    CHECK(bounds.max.x == doctest::Approx(2.0f));
+    CHECK(bounds.max.y == doctest::Approx(2.0f));
+
+    // The broadphase has to return every collider the narrowphase hits
+    Math::AABB start = GetEllipseBounds(ellipse);
+    Math::AABB end = { .min = start.min + velocity, .max = start.max + velocity };
+    SpatialGrid<int> grid;
+    grid.arena = &arena;
+    grid.cellSize = 1.0f;
+    int value = 1;
+    grid.Insert(0, &value, bounds);
+    int found = 0;
+    grid.Query(Math::Union(start, end), [&](int* item)
+    {
+        found += *item;
+    });
+    CHECK(found == 1);
+
+    // Static colliders are found by casting the ellipse's bounds through the BVH
+    Bvh<int> bvh;
+    bvh.arena = &arena;
+    Bvh<int>::Item item = { .id = 0, .value = &value, .bounds = bounds };
+    bvh.Build(Span<Bvh<int>::Item>(&item, 1));
+    found = 0;
+    bvh.Cast(start, velocity, [&](Span<int*> leaf)
+    {
+        for (int* leafValue : leaf)
+        {
+            found += leafValue != nullptr ? *leafValue : 0;
+        }
+        return 1.0f;
+    });
+    CHECK(found == 1);
+
+    arena.Free();
+}
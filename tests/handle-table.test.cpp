@@ -0,0 +1,120 @@
+#include "data-structures.hpp"
+#include <doctest.h>
+
+TEST_CASE("Handle Table")
+{
+    MemoryArena arena;
+    arena.Init(1024, MemoryArenaFlags_ClearToZero);
+
+    HandleTable<int> table;
+    table.arena = &arena;
+
+    int values[4] = { 0, 1, 2, 3 };
+
+    SUBCASE("Creating and resolving")
+    {
+        CHECK(table.Get(Handle<int>{}) == nullptr);
+
+        Handle<int> handles[4];
+        for (int i = 0; i < 4; i++)
+        {
+            handles[i] = table.Create(&values[i]);
+            CHECK(!handles[i].IsNull());
+            CHECK(handles[i].GetIndex() == (uint32_t)i);
+        }
+        for (int i = 0; i < 4; i++)
+        {
+            CHECK(table.Get(handles[i]) == &values[i]);
+        }
+        CHECK(table.size == 4);
+        CHECK(table.GetIndexCount() == 4);
+    }
+
+    SUBCASE("Stale handles")
+    {
+        Handle<int> first = table.Create(&values[0]);
+        table.Create(&values[1]);
+        table.Destroy(first);
+        CHECK(table.Get(first) == nullptr);
+
+        // The slot is reused, but the old handle must not resolve to the new value
+        Handle<int> reused = table.Create(&values[2]);
+        CHECK(reused.GetIndex() == first.GetIndex());
+        CHECK(reused != first);
+        CHECK(table.Get(reused) == &values[2]);
+        CHECK(table.Get(first) == nullptr);
+        CHECK(table.GetIndexCount() == 2);
+    }
+
+    SUBCASE("Looking up by index")
+    {
+        Handle<int> first = table.Create(&values[0]);
+        table.Create(&values[1]);
+        CHECK(table.GetAtIndex(0) == &values[0]);
+        CHECK(table.GetAtIndex(1) == &values[1]);
+        CHECK(table.GetAtIndex(2) == nullptr);
+
+        table.Destroy(first);
+        CHECK(table.GetAtIndex(0) == nullptr);
+        CHECK(table.GetAtIndex(1) == &values[1]);
+    }
+
+    SUBCASE("Generations wrap around without producing null handles")
+    {
+        Handle<int> handle = table.Create(&values[0]);
+        for (uint32_t i = 0; i < Handle<int>::GenerationMask + 2; i++)
+        {
+            table.Destroy(handle);
+            handle = table.Create(&values[0]);
+            CHECK(handle.GetGeneration() != 0);
+            CHECK(handle.GetIndex() == 0);
+        }
+        CHECK(table.Get(handle) == &values[0]);
+    }
+
+    SUBCASE("Reset")
+    {
+        Handle<int> handle = table.Create(&values[0]);
+        table.Reset();
+        CHECK(table.size == 0);
+
+        Handle<int> newHandle = table.Create(&values[1]);
+        CHECK(newHandle.GetIndex() == handle.GetIndex());
+        CHECK(table.Get(handle) == nullptr);
+        CHECK(table.Get(newHandle) == &values[1]);
+    }
+
+    SUBCASE("Reset after slots were reused")
+    {
+        // The slot's generation has already moved past the one new slots start at
+        Handle<int> first = table.Create(&values[0]);
+        table.Destroy(first);
+        Handle<int> second = table.Create(&values[1]);
+        CHECK(second.GetIndex() == first.GetIndex());
+
+        table.Reset();
+        Handle<int> third = table.Create(&values[2]);
+        CHECK(third.GetIndex() == second.GetIndex());
+        CHECK(table.Get(first) == nullptr);
+        CHECK(table.Get(second) == nullptr);
+        CHECK(table.Get(third) == &values[2]);
+    }
+
+    SUBCASE("Resets only move on the slots that were in use")
+    {
+        table.Create(&values[0]);
+        Handle<int> stale = table.Create(&values[1]);
+        table.Destroy(stale);
+
+        // Far more resets than there are generations, with only the first slot in use between them
+        for (uint32_t i = 0; i < Handle<int>::GenerationMask + 2; i++)
+        {
+            table.Reset();
+            CHECK(table.Create(&values[2]).GetIndex() == 0);
+        }
+        CHECK(table.Get(stale) == nullptr);
+        CHECK(table.GetIndexCount() == 2);
+    }
+
+    arena.Free();
+}
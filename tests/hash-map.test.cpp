@@ -0,0 +1,149 @@
+#include "data-structures.hpp"
+#include <doctest.h>
+#include <unordered_map>
+#include <random>
+
+TEST_CASE("Hash Map")
+{
+    MemoryArena arena;
+    arena.Init(1024, MemoryArenaFlags_ClearToZero);
+
+    SUBCASE("Inserting and finding")
+    {
+        HashMap<int, int> map;
+        map.arena = &arena;
+
+        CHECK(map.Find(1) == nullptr);
+        for (int i = 0; i < 1000; i++)
+        {
+            map.Insert(i, i * 2);
+        }
+        CHECK(map.size == 1000);
+        for (int i = 0; i < 1000; i++)
+        {
+            REQUIRE(map.Find(i) != nullptr);
+            CHECK(*map.Find(i) == i * 2);
+        }
+        CHECK(map.Find(1000) == nullptr);
+        CHECK(map.Find(-1) == nullptr);
+
+        map.Insert(5, 0);
+        CHECK(*map.Find(5) == 0);
+        CHECK(map.size == 1000);
+    }
+
+    SUBCASE("operator[] inserts default values")
+    {
+        HashMap<uint32_t, float> map;
+        map.arena = &arena;
+
+        CHECK(map[7] == 0.0f);
+        map[7] += 1.5f;
+        map[7] += 1.5f;
+        CHECK(map[7] == 3.0f);
+        CHECK(map.size == 1);
+    }
+
+    SUBCASE("String keys")
+    {
+        HashMap<StringView, int> map;
+        map.arena = &arena;
+
+        map.Insert("left_eyebrow_angle", 1);
+        map.Insert("right_eyebrow_angle", 2);
+        map["left_eyebrow_height"] = 3;
+
+        String key = String::Copy("right_eyebrow_angle", &arena);
+        REQUIRE(map.Find(key) != nullptr);
+        CHECK(*map.Find(key) == 2);
+        CHECK(map.Contains("left_eyebrow_height"));
+        CHECK(!map.Contains("left_eyebrow"));
+    }
+
+    SUBCASE("Erase() keeps the other entries reachable")
+    {
+        HashMap<int, int> map;
+        map.arena = &arena;
+
+        for (int i = 0; i < 500; i++)
+        {
+            map.Insert(i, i);
+        }
+        for (int i = 0; i < 500; i += 2)
+        {
+            CHECK(map.Erase(i));
+        }
+        CHECK(!map.Erase(0));
+        CHECK(map.size == 250);
+        for (int i = 0; i < 500; i++)
+        {
+            CHECK(map.Contains(i) == (i % 2 == 1));
+        }
+    }
+
+    SUBCASE("Iteration")
+    {
+        HashMap<int, int> map;
+        map.arena = &arena;
+
+        for ([[maybe_unused]] auto& [key, value] : map)
+        {
+            CHECK(false);
+        }
+        for (int i = 0; i < 100; i++)
+        {
+            map.Insert(i, i);
+        }
+        int sum = 0;
+        int count = 0;
+        for (auto& [key, value] : map)
+        {
+            CHECK(key == value);
+            sum += value;
+            count++;
+        }
+        CHECK(count == 100);
+        CHECK(sum == 99 * 100 / 2);
+
+        map.Clear();
+        CHECK(map.size == 0);
+        CHECK(map.begin() == map.end());
+    }
+
+    SUBCASE("Matches std::unordered_map under random operations")
+    {
+        HashMap<uint64_t, uint64_t> map;
+        map.arena = &arena;
+        std::unordered_map<uint64_t, uint64_t> reference;
+
+        std::mt19937_64 random(1234);
+        for (int i = 0; i < 20000; i++)
+        {
+            uint64_t key = random() % 2048;
+            switch (random() % 3)
+            {
+                case 0:
+                    map.Insert(key, i);
+                    reference[key] = i;
+                    break;
+                case 1:
+                    CHECK(map.Erase(key) == (reference.erase(key) == 1));
+                    break;
+                case 2:
+                {
+                    auto it = reference.find(key);
+                    uint64_t* value = map.Find(key);
+                    CHECK((value != nullptr) == (it != reference.end()));
+                    if (value != nullptr && it != reference.end())
+                    {
+                        CHECK(*value == it->second);
+                    }
+                    break;
+                }
+            }
+            REQUIRE(map.size == reference.size());
+        }
+    }
+
+    arena.Free();
+}
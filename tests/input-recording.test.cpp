@@ -0,0 +1,117 @@
+#include "input-recording.hpp"
+#include <doctest.h>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+TEST_CASE("Input Recording")
+{
+    const char* path = "input-recording.test.bin";
+
+    auto SendKey = [](Input& input, SDL_Scancode scancode, bool down)
+    {
+        SDL_Event event{};
+        event.type = down ? SDL_EVENT_KEY_DOWN : SDL_EVENT_KEY_UP;
+        event.key.scancode = scancode;
+        input.OnEvent(event);
+    };
+    auto SendMouse = [](Input& input, Math::float2 position, bool down)
+    {
+        SDL_Event event{};
+        event.type = SDL_EVENT_MOUSE_MOTION;
+        event.motion.x = position.x;
+        event.motion.y = position.y;
+        input.OnEvent(event);
+
+        event = {};
+        event.type = down ? SDL_EVENT_MOUSE_BUTTON_DOWN : SDL_EVENT_MOUSE_BUTTON_UP;
+        event.button.button = 1;
+        input.OnEvent(event);
+    };
+
+    // Long stretches of unchanged frames with bursts of key presses, mouse movement and a rebind in between
+    constexpr SDL_Scancode Scancodes[] = { SDL_SCANCODE_A, SDL_SCANCODE_D, SDL_SCANCODE_W, SDL_SCANCODE_SPACE, SDL_SCANCODE_LSHIFT };
+    constexpr int FrameCount = 3000;
+    std::mt19937 rng(1234);
+    std::vector<Input> frames;
+
+    InputRecording::Recorder recorder;
+    REQUIRE(recorder.Start(path, 7));
+    Input input;
+    for (int frame = 0; frame < FrameCount; frame++)
+    {
+        if (rng() % 20 == 0)
+        {
+            SendKey(input, Scancodes[rng() % std::size(Scancodes)], rng() % 2 == 0);
+        }
+        if (rng() % 200 == 0)
+        {
+            SendMouse(input, { (float)(rng() % 640), (float)(rng() % 480) }, rng() % 2 == 0);
+        }
+        if (frame == FrameCount / 2)
+        {
+            input.controls[(int)Key::Jump][2] = SDL_SCANCODE_LSHIFT;
+        }
+        recorder.RecordFrame(input);
+        frames.push_back(input);
+        input.EndFrame();
+    }
+    CHECK(recorder.GetFrameCount() == FrameCount);
+    recorder.Stop();
+
+    MemoryArena arena;
+    arena.Init(64 * 1024, MemoryArenaFlags_ClearToZero);
+
+    InputRecording::Replay replay;
+    REQUIRE(replay.Load(path, &arena));
+    CHECK(replay.GetStartState() == 7);
+
+    Input replayed;
+    for (int frame = 0; frame < FrameCount; frame++)
+    {
+        REQUIRE(replay.NextFrame(replayed));
+        const Input& expected = frames[frame];
+        for (int key = 0; key < (int)Key::Count; key++)
+        {
+            CHECK(replayed.IsKeyDown((Key)key) == expected.IsKeyDown((Key)key));
+            CHECK(replayed.IsKeyPressed((Key)key) == expected.IsKeyPressed((Key)key));
+        }
+        CHECK(replayed.GetFirstKeyPressed() == expected.GetFirstKeyPressed());
+        CHECK(replayed.GetMousePosition().x == expected.GetMousePosition().x);
+        CHECK(replayed.GetMousePosition().y == expected.GetMousePosition().y);
+        CHECK(replayed.IsMouseDown() == expected.IsMouseDown());
+        CHECK(replayed.IsMousePressed() == expected.IsMousePressed());
+        CHECK(replayed.controls == expected.controls);
+        replayed.EndFrame();
+    }
+    CHECK(!replay.NextFrame(replayed));
+    CHECK(!replay.IsActive());
+
+    // Unchanged frames only cost their share of a repeat count
+    FILE* file = fopen(path, "rb");
+    REQUIRE(file != nullptr);
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    CHECK(size < FrameCount);
+
+    // Cut off recordings play up to the damage and then stop
+    std::vector<uint8_t> data(size);
+    file = fopen(path, "rb");
+    REQUIRE(fread(data.data(), 1, size, file) == (size_t)size);
+    fclose(file);
+    data[0] ^= 0xff;
+    CHECK(!replay.Load(Span<const uint8_t>(data.data(), data.size())));
+    data[0] ^= 0xff;
+    data.resize(size - 3);
+    REQUIRE(replay.Load(Span<const uint8_t>(data.data(), data.size())));
+    int playedFrames = 0;
+    while (replay.NextFrame(replayed))
+    {
+        playedFrames++;
+    }
+    CHECK(playedFrames < FrameCount);
+
+    remove(path);
+    arena.Free();
+}
@@ -0,0 +1,234 @@
+#include "log.hpp"
+#include <doctest.h>
+#include <thread>
+#include <cstdio>
+
+TEST_CASE("Log Formatting")
+{
+    char buffer[64];
+
+    SUBCASE("Arguments are inserted in order")
+    {
+        StringView result = Log::FormatTo(buffer, sizeof(buffer), "% + % = %", 1, 2u, 3.5f);
+        CHECK(result == "1 + 2 = 3.500000");
+        CHECK(result.data == buffer);
+
+        result = Log::FormatTo(buffer, sizeof(buffer), "Entity '%' at %", StringView("Ground"), Math::float2(1.0f, -2.0f));
+        CHECK(result == "Entity 'Ground' at (1.000000, -2.000000)");
+
+        result = Log::FormatTo(buffer, sizeof(buffer), "No arguments");
+        CHECK(result == "No arguments");
+    }
+
+    SUBCASE("Escaped insertions")
+    {
+        StringView result = Log::FormatTo(buffer, sizeof(buffer), "%\\% done", 50);
+        CHECK(result == "50% done");
+    }
+
+    SUBCASE("Output is cut off at the end of the buffer")
+    {
+        StringView result = Log::FormatTo(buffer, 8, "Value: %", 123456);
+        CHECK(result == "Value: 1");
+
+        result = Log::FormatTo(buffer, 3, "%%%", -100, 'a', "b");
+        CHECK(result == "-10");
+    }
+
+    SUBCASE("Formatting into a String")
+    {
+        MemoryArena arena;
+        arena.Init(1024, MemoryArenaFlags_ClearToZero);
+
+        String result = Log::Format(&arena, "% Bind Group", StringView("sprite"));
+        CHECK(result == "sprite Bind Group");
+
+        arena.Free();
+    }
+}
+
+TEST_CASE("Async Log Writer")
+{
+    const char* path = "async-log.test.txt";
+    REQUIRE(Log::StartAsyncWriter(path));
+
+    constexpr int ThreadCount = 4;
+    constexpr int MessagesPerThread = 2000;
+
+    uint64_t droppedBefore = Log::GetDroppedCount();
+    std::thread threads[ThreadCount];
+    for (int i = 0; i < ThreadCount; i++)
+    {
+        threads[i] = std::thread([i]
+        {
+            for (int j = 0; j < MessagesPerThread; j++)
+            {
+                Log::Info("Thread % message %", i, j);
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    Log::StopAsyncWriter();
+    uint64_t dropped = Log::GetDroppedCount() - droppedBefore;
+
+    FILE* file = fopen(path, "rb");
+    REQUIRE(file != nullptr);
+    char line[256];
+    size_t messageLines = 0;
+    while (fgets(line, sizeof(line), file) != nullptr)
+    {
+        StringView view(line);
+        CHECK(view.EndsWith("\n"));
+        if (view.StartsWith("[INFO] Thread "))
+        {
+            messageLines++;
+        }
+        else
+        {
+            // Only the report about dropped messages may be interleaved
+            CHECK(view.StartsWith("[WARN] [LOG] Dropped "));
+        }
+    }
+    fclose(file);
+    remove(path);
+
+    // Every message is either written out or counted as dropped
+    CHECK(messageLines + dropped == ThreadCount * MessagesPerThread);
+}
+
+TEST_CASE("Binary Log")
+{
+    const char* path = "binary-log.test.bin";
+    Log::SetLogLevel(Log::LogLevel::Debug);
+    REQUIRE(Log::StartBinaryLog(path));
+
+    Log::Debug("Create entity draw data (%)", 42u);
+    Log::Info("Entity '%' at % with % and %", StringView("Ground"), Math::float2(1.0f, 2.0f), -3, 'x');
+    Log::Warn("%\\% of the ring is in use", 0.5);
+    Log::Info(StringView("Preformatted message"));
+    // Errors are also written as text, but only recorded once
+    Log::Error("Value is %", 42);
+    Log::Error(StringView("Preformatted error"));
+    for (int i = 0; i < 5000; i++)
+    {
+        // Enough records to spill over several chunks, each of which has to define its formats again
+        Log::Debug("Step %", i);
+    }
+
+    Log::StopBinaryLog();
+    Log::SetLogLevel(Log::LogLevel::Info);
+
+    FILE* file = fopen(path, "rb");
+    REQUIRE(file != nullptr);
+    uint8_t data[256 * 1024];
+    size_t size = fread(data, sizeof(uint8_t), sizeof(data), file);
+    fclose(file);
+    remove(path);
+
+    MemoryArena arena;
+    arena.Init(1024 * 1024, MemoryArenaFlags_VirtualMemory);
+    String text;
+    text.arena = &arena;
+    REQUIRE(Log::Binary::Decode(Span<const uint8_t>(data, size), text));
+
+    // Strip the timestamps, which are the only part of each line that changes between runs
+    Array<StringView> lines;
+    lines.arena = &arena;
+    StringView view = text;
+    size_t lineStart = 0;
+    for (size_t i = 0; i < view.size; i++)
+    {
+        if (view[i] == '\n')
+        {
+            StringView line = view.Substr(lineStart, i - lineStart);
+            lines.Push(line.Substr(line.Find(']', 0) + 2));
+            lineStart = i + 1;
+        }
+    }
+
+    REQUIRE(lines.size == 5006);
+    CHECK(lines[0] == "[DEBUG] Create entity draw data (42)");
+    CHECK(lines[1] == "[INFO] Entity 'Ground' at (1.000000, 2.000000) with -3 and x");
+    CHECK(lines[2] == "[WARN] 0.500000% of the ring is in use");
+    CHECK(lines[3] == "[INFO] Preformatted message");
+    CHECK(lines[4] == "[ERROR] Value is 42");
+    CHECK(lines[5] == "[ERROR] Preformatted error");
+    CHECK(lines[6] == "[DEBUG] Step 0");
+    CHECK(lines[5005] == "[DEBUG] Step 4999");
+
+    SUBCASE("Cut off logs fail to decode")
+    {
+        String cutOff;
+        cutOff.arena = &arena;
+        CHECK(!Log::Binary::Decode(Span<const uint8_t>(data, size - 3), cutOff));
+    }
+
+    arena.Free();
+}
+
+TEST_CASE("Rate Limited Logging")
+{
+    const char* path = "rate-limit.test.txt";
+    REQUIRE(Log::StartAsyncWriter(path));
+    Log::SetRateLimitInterval(0.0f);
+
+    static Log::RateLimit rateLimit(3);
+    for (int i = 0; i < 100; i++)
+    {
+        Log::Warn(rateLimit, "Repeated warning %", i);
+    }
+    CHECK(rateLimit.count == 100);
+
+    Log::UpdateRateLimits();
+    CHECK(rateLimit.count == 0);
+
+    // The new interval lets messages through again
+    Log::Warn(rateLimit, "Repeated warning %", 100);
+
+    Log::StopAsyncWriter();
+    Log::SetRateLimitInterval(1.0f);
+
+    FILE* file = fopen(path, "rb");
+    REQUIRE(file != nullptr);
+    char text[1024];
+    size_t size = fread(text, sizeof(char), sizeof(text), file);
+    fclose(file);
+    remove(path);
+
+    // Other rate limits from earlier tests may report in between, only keep the lines about this one
+    MemoryArena arena;
+    arena.Init(4096, MemoryArenaFlags_ClearToZero);
+    String lines;
+    lines.arena = &arena;
+    StringView view(text, size);
+    size_t lineStart = 0;
+    for (size_t i = 0; i < view.size; i++)
+    {
+        if (view[i] != '\n')
+        {
+            continue;
+        }
+        StringView line = view.Substr(lineStart, i - lineStart + 1);
+        for (size_t j = 0; j < line.size; j++)
+        {
+            if (line.Substr(j).StartsWith("Repeated warning"))
+            {
+                lines += line;
+                break;
+            }
+        }
+        lineStart = i + 1;
+    }
+
+    CHECK(lines ==
+        "[WARN] Repeated warning 0\n"
+        "[WARN] Repeated warning 1\n"
+        "[WARN] Repeated warning 2\n"
+        "[WARN] [LOG] Suppressed 97 repeats of 'Repeated warning %'\n"
+        "[WARN] Repeated warning 100\n");
+
+    arena.Free();
+}
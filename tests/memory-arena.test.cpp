@@ -1,6 +1,10 @@
 #include "memory-arena.hpp"
+#include "data-structures.hpp"
 #include <doctest.h>
 
+#include <thread>
+#include <latch>
+
 TEST_CASE("Memory Arena")
 {
     MemoryArena arena;
@@ -195,3 +199,271 @@ TEST_CASE("Memory Arena")
 
     arena.Free();
 }
+
+TEST_CASE("Virtual Memory Arena")
+{
+    MemoryArena arena;
+    arena.Init(64, MemoryArenaFlags_ClearToZero | MemoryArenaFlags_VirtualMemory);
+
+    const size_t retainedSize = arena.committed;
+    CHECK(retainedSize == MemoryArena::VirtualCommitGranularity);
+    CHECK(arena.size == MemoryArena::VirtualReserveSize);
+
+    SUBCASE("Allocating more memory than the initial size never chains")
+    {
+        uint8_t* a = arena.Alloc<uint8_t>(retainedSize);
+        uint8_t* b = arena.Alloc<uint8_t>(retainedSize * 4);
+
+        CHECK(arena.next == nullptr);
+        CHECK(b == a + retainedSize);
+        CHECK(arena.committed == retainedSize * 5);
+
+        for (size_t i = 0; i < retainedSize * 4; i++)
+        {
+            CHECK(b[i] == 0);
+        }
+    }
+
+    SUBCASE("Growing the most recent allocation never copies")
+    {
+        uint8_t* a = arena.Alloc<uint8_t>(16);
+        for (int i = 0; i < 16; i++)
+        {
+            a[i] = i + 1;
+        }
+
+        uint8_t* b = arena.Realloc<uint8_t>(a, 16, retainedSize * 8);
+        CHECK(a == b);
+        for (int i = 0; i < 16; i++)
+        {
+            CHECK(b[i] == i + 1);
+        }
+    }
+
+    SUBCASE("Clear() decommits pages beyond the initial size and zeroes the rest")
+    {
+        uint8_t* a = arena.Alloc<uint8_t>(retainedSize * 2);
+        for (size_t i = 0; i < retainedSize * 2; i++)
+        {
+            a[i] = ~(uint8_t)0;
+        }
+
+        arena.Clear();
+        CHECK(arena.offset == 0);
+        CHECK(arena.committed == retainedSize);
+
+        uint8_t* b = arena.Alloc<uint8_t>(retainedSize * 2);
+        CHECK(a == b);
+        for (size_t i = 0; i < retainedSize * 2; i++)
+        {
+            CHECK(b[i] == 0);
+        }
+    }
+
+    arena.Free();
+    CHECK(arena.data == nullptr);
+    CHECK(arena.committed == 0);
+}
+
+TEST_CASE("Concurrent Arena")
+{
+    ConcurrentArena arena;
+    arena.Init(64, MemoryArenaFlags_ClearToZero);
+
+    SUBCASE("Each thread gets its own chunk")
+    {
+        constexpr int NUM_THREADS = 8;
+        constexpr int NUM_ALLOCATIONS = 4096;
+
+        std::array<uint32_t*, NUM_THREADS> firstAllocations{};
+        std::array<bool, NUM_THREADS> success{};
+        std::array<std::thread, NUM_THREADS> threads;
+        for (int t = 0; t < NUM_THREADS; t++)
+        {
+            threads[t] = std::thread([&, t]
+            {
+                MemoryArena* threadArena = arena.GetThreadArena();
+
+                Array<uint32_t> array;
+                array.arena = threadArena;
+                for (int i = 0; i < NUM_ALLOCATIONS; i++)
+                {
+                    array.Push(t * NUM_ALLOCATIONS + i);
+
+                    // Interleave some unrelated allocations so the array can't always grow in place
+                    uint32_t* other = threadArena->Alloc<uint32_t>(3);
+                    other[0] = other[1] = other[2] = ~(uint32_t)0;
+                }
+
+                success[t] = true;
+                for (int i = 0; i < NUM_ALLOCATIONS; i++)
+                {
+                    success[t] = success[t] && array[i] == (uint32_t)(t * NUM_ALLOCATIONS + i);
+                }
+                firstAllocations[t] = array.data;
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        for (int t = 0; t < NUM_THREADS; t++)
+        {
+            CHECK(success[t]);
+            for (int u = 0; u < t; u++)
+            {
+                CHECK(firstAllocations[t] != firstAllocations[u]);
+            }
+        }
+    }
+
+    SUBCASE("Clear() resets every thread's chunk and zeroes memory")
+    {
+        MemoryArena* threadArena = arena.GetThreadArena();
+        uint64_t* a = threadArena->Alloc<uint64_t>(16);
+        for (int i = 0; i < 16; i++)
+        {
+            a[i] = ~(uint64_t)0;
+        }
+
+        arena.Clear();
+        CHECK(threadArena->data == nullptr);
+
+        uint64_t* b = threadArena->Alloc<uint64_t>(16);
+        CHECK(a == b);
+        for (int i = 0; i < 16; i++)
+        {
+            CHECK(b[i] == 0);
+        }
+    }
+
+    SUBCASE("Threads give their slots back when they exit")
+    {
+        ConcurrentArena other;
+        other.Init(64, MemoryArenaFlags_ClearToZero);
+
+        // Far more threads than there are slots, but never more than a few at once
+        constexpr int NUM_BATCHES = 3 * ConcurrentArena::MaxThreads;
+        constexpr int NUM_THREADS = 4;
+
+        bool success = true;
+        for (int batch = 0; batch < NUM_BATCHES; batch++)
+        {
+            std::array<MemoryArena*, NUM_THREADS> threadArenas{};
+            std::array<std::thread, NUM_THREADS> threads;
+            std::latch allHoldSlots(NUM_THREADS);
+            for (int t = 0; t < NUM_THREADS; t++)
+            {
+                threads[t] = std::thread([&, t]
+                {
+                    threadArenas[t] = arena.GetThreadArena();
+                    uint32_t* value = threadArenas[t]->Alloc<uint32_t>();
+                    *value = t;
+                    allHoldSlots.arrive_and_wait();
+
+                    // Slots are per arena, so using a second one doesn't take up a slot in the first
+                    other.GetThreadArena()->Alloc<uint32_t>();
+                });
+            }
+            for (std::thread& thread : threads)
+            {
+                thread.join();
+            }
+            for (int t = 0; t < NUM_THREADS; t++)
+            {
+                for (int u = 0; u < t; u++)
+                {
+                    success = success && threadArenas[t] != threadArenas[u];
+                }
+            }
+        }
+        CHECK(success);
+
+        other.Free();
+    }
+
+    arena.Free();
+}
+
+TEST_CASE("Arena Temp")
+{
+    MemoryArena arena;
+    arena.Init(64, MemoryArenaFlags_ClearToZero);
+
+    SUBCASE("Rewinds to the saved offset and zeroes scratch memory")
+    {
+        uint32_t* before = arena.Alloc<uint32_t>(2);
+        size_t savedOffset = arena.offset;
+        uint32_t* scratch = nullptr;
+        {
+            ArenaTemp temp(&arena);
+            scratch = arena.Alloc<uint32_t>(4);
+            scratch[0] = scratch[3] = ~(uint32_t)0;
+        }
+        CHECK(arena.offset == savedOffset);
+        CHECK(scratch[0] == 0);
+        CHECK(scratch[3] == 0);
+        CHECK(arena.Alloc<uint32_t>(4) == scratch);
+        CHECK(before + 2 == scratch);
+    }
+
+    SUBCASE("Nested savepoints")
+    {
+        ArenaTemp outer(&arena);
+        arena.Alloc<uint8_t>(8);
+        {
+            ArenaTemp inner(&arena);
+            arena.Alloc<uint8_t>(8);
+            CHECK(arena.offset == 16);
+        }
+        CHECK(arena.offset == 8);
+    }
+
+    SUBCASE("Rewinds across chained blocks")
+    {
+        arena.Alloc<uint8_t>(32);
+        {
+            ArenaTemp temp(&arena);
+            uint8_t* a = arena.Alloc<uint8_t>(arena.size);
+            uint8_t* b = arena.Alloc<uint8_t>(arena.size);
+            a[0] = b[0] = 1;
+
+            REQUIRE(arena.next != nullptr);
+            REQUIRE(arena.next->next != nullptr);
+        }
+        CHECK(arena.offset == 32);
+        CHECK(arena.next->offset == 0);
+        CHECK(arena.next->next->offset == 0);
+
+        {
+            ArenaTemp temp(&arena);
+            uint8_t* c = arena.Alloc<uint8_t>(48);
+            uint8_t* d = arena.Alloc<uint8_t>(48);
+            uint8_t* e = arena.Alloc<uint8_t>(16);
+            CHECK(c == arena.next->data);
+            CHECK(d == arena.next->next->data);
+            CHECK(e == (uint8_t*)arena.data + 32);
+        }
+        CHECK(arena.offset == 32);
+        CHECK(arena.next->offset == 0);
+        CHECK(arena.next->next->offset == 0);
+    }
+
+    SUBCASE("High-water mark stays flat with a virtual memory arena")
+    {
+        arena.Free();
+        arena.Init(64, MemoryArenaFlags_ClearToZero | MemoryArenaFlags_VirtualMemory);
+
+        for (int i = 0; i < 64; i++)
+        {
+            ArenaTemp temp(&arena);
+            arena.Alloc<uint8_t>(1024);
+            CHECK(arena.offset == 1024);
+        }
+        CHECK(arena.offset == 0);
+        CHECK(arena.committed == MemoryArena::VirtualCommitGranularity);
+    }
+
+    arena.Free();
+}
@@ -0,0 +1,89 @@
+#include "memory-arena.hpp"
+#include "data-structures.hpp"
+#include <doctest.h>
+
+TEST_CASE("Memory Pool")
+{
+    MemoryArena arena;
+    arena.Init(64 * 1024, MemoryArenaFlags_ClearToZero);
+
+    MemoryPool pool;
+    pool.arena = &arena;
+
+    SUBCASE("Size classes")
+    {
+        CHECK(MemoryPool::GetSizeClass(1) == 0);
+        CHECK(MemoryPool::GetSizeClass(16) == 0);
+        CHECK(MemoryPool::GetSizeClass(17) == 1);
+        CHECK(MemoryPool::GetSizeClass(MemoryPool::MaxBlockSize) == MemoryPool::NumSizeClasses - 1);
+        CHECK(MemoryPool::GetBlockSize(MemoryPool::NumSizeClasses - 1) == MemoryPool::MaxBlockSize);
+    }
+
+    SUBCASE("Freed blocks are recycled")
+    {
+        void* a = pool.Alloc(24, 8);
+        void* b = pool.Alloc(24, 8);
+        CHECK(a != b);
+        CHECK((uintptr_t)a % MemoryPool::MinBlockSize == 0);
+
+        memset(a, 0xff, 24);
+        pool.Free(a, 24);
+        void* c = pool.Alloc(32, 8);
+        CHECK(c == a);
+        for (int i = 0; i < 32; i++)
+        {
+            CHECK(((uint8_t*)c)[i] == 0);
+        }
+    }
+
+    SUBCASE("Realloc within a size class")
+    {
+        char* data = (char*)pool.Alloc(20, 1);
+        data[0] = 'a';
+        CHECK(pool.Realloc(data, 20, 30, 1) == data);
+
+        char* grown = (char*)pool.Realloc(data, 30, 100, 1);
+        CHECK(grown != data);
+        CHECK(grown[0] == 'a');
+        CHECK(pool.Alloc(30, 1) == data);
+    }
+
+    SUBCASE("Arena usage stays flat")
+    {
+        for (int i = 0; i < 1000; i++)
+        {
+            void* data = pool.Alloc(100, 8);
+            pool.Free(data, 100);
+        }
+        size_t offset = arena.offset;
+        for (int i = 0; i < 1000; i++)
+        {
+            void* data = pool.Alloc(100, 8);
+            pool.Free(data, 100);
+        }
+        CHECK(arena.offset == offset);
+    }
+
+    SUBCASE("Pooled strings")
+    {
+        size_t offset = 0;
+        for (int i = 0; i < 100; i++)
+        {
+            String str;
+            str.pool = &pool;
+            str.Reserve(16);
+            str += "Entity name that outgrows the first block";
+            CHECK(str == "Entity name that outgrows the first block");
+            str.Free();
+            CHECK(str.data == nullptr);
+
+            if (i == 0)
+            {
+                offset = arena.offset;
+            }
+        }
+        CHECK(arena.offset == offset);
+    }
+
+    arena.Free();
+}
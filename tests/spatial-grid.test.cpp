@@ -0,0 +1,100 @@
+#include "spatial-grid.hpp"
+#include <doctest.h>
+#include <random>
+#include <set>
+
+TEST_CASE("Spatial Grid")
+{
+    MemoryArena arena;
+    arena.Init(1024, MemoryArenaFlags_ClearToZero);
+
+    SpatialGrid<int> grid;
+    grid.arena = &arena;
+    grid.cellSize = 1.0f;
+
+    constexpr int ItemCount = 500;
+    int values[ItemCount];
+    Math::AABB bounds[ItemCount];
+    bool inserted[ItemCount] = {};
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+    std::uniform_real_distribution<float> extent(0.01f, 3.0f);
+    auto RandomBounds = [&]
+    {
+        Math::float2 center = { position(rng), position(rng) };
+        Math::float2 halfSize = { extent(rng), extent(rng) };
+        // A few items are large enough to be kept in the oversized list
+        if (rng() % 50 == 0)
+        {
+            halfSize = { 20.0f, 20.0f };
+        }
+        return Math::AABB{
+            .min = { center.x - halfSize.x, center.y - halfSize.y },
+            .max = { center.x + halfSize.x, center.y + halfSize.y }
+        };
+    };
+    auto Overlaps = [](const Math::AABB& a, const Math::AABB& b)
+    {
+        return a.min.x <= b.max.x && a.max.x >= b.min.x && a.min.y <= b.max.y && a.max.y >= b.min.y;
+    };
+
+    for (int i = 0; i < ItemCount; i++)
+    {
+        values[i] = i;
+        bounds[i] = RandomBounds();
+        grid.Insert(i, &values[i], bounds[i]);
+        inserted[i] = true;
+    }
+
+    // Move and remove some of the items to exercise Update() and Remove()
+    for (int i = 0; i < ItemCount; i += 3)
+    {
+        bounds[i] = RandomBounds();
+        grid.Update(i, bounds[i]);
+    }
+    for (int i = 0; i < ItemCount; i += 7)
+    {
+        grid.Remove(i);
+        inserted[i] = false;
+    }
+    CHECK(grid.Contains(1));
+    CHECK(!grid.Contains(7));
+
+    for (int query = 0; query < 200; query++)
+    {
+        Math::AABB queryBounds = RandomBounds();
+        if (query % 20 == 0)
+        {
+            // Larger than the number of occupied cells, so the occupied cells are walked instead
+            queryBounds = { .min = { -200.0f, -200.0f }, .max = { 200.0f, 200.0f } };
+        }
+
+        std::set<int> found;
+        grid.Query(queryBounds, [&](int* value)
+        {
+            // Every item is reported at most once per query
+            CHECK(found.insert(*value).second);
+        });
+
+        // Every item overlapping the query has to be found, the rest only may be
+        for (int i = 0; i < ItemCount; i++)
+        {
+            if (inserted[i] && Overlaps(bounds[i], queryBounds))
+            {
+                CHECK(found.contains(i));
+            }
+            if (!inserted[i])
+            {
+                CHECK(!found.contains(i));
+            }
+        }
+    }
+
+    grid.Clear();
+    int visited = 0;
+    grid.Query({ .min = { -200.0f, -200.0f }, .max = { 200.0f, 200.0f } }, [&](int*) { visited++; });
+    CHECK(visited == 0);
+
+    arena.Free();
+}
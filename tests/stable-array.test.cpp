@@ -178,3 +178,87 @@ TEST_CASE("Stable Array")
         }
     }
 }
+
+TEST_CASE("Indexed Stable Array")
+{
+    MemoryArena arena;
+    arena.Init(1024, MemoryArenaFlags_ClearToZero);
+
+    IndexedStableArray<int> array;
+    array.arena = &arena;
+
+    constexpr size_t NumElements = array.BlockSize * 100;
+    std::array<int*, NumElements> ptrs;
+    for (int i = 0; i < ptrs.size(); i++)
+    {
+        ptrs[i] = array.Push(i + 1);
+    }
+
+    SUBCASE("Pointers are stable")
+    {
+        CHECK(array.blocks.size == 100);
+        CHECK(array.size == NumElements);
+        for (int i = 0; i < ptrs.size(); i++)
+        {
+            CHECK(*ptrs[i] == i + 1);
+        }
+    }
+
+    SUBCASE("Erase() frees up the earliest slots first")
+    {
+        for (int i = 0; i < ptrs.size(); i += 3)
+        {
+            array.Erase(ptrs[i]);
+        }
+        for (int i = 0; i < ptrs.size(); i += 3)
+        {
+            CHECK(array.Push(-i) == ptrs[i]);
+        }
+        CHECK(array.blocks.size == 100);
+        CHECK(array.size == NumElements);
+        CHECK(*array.Push(0) == 0);
+        CHECK(array.blocks.size == 101);
+    }
+
+    SUBCASE("Iterating with empty blocks")
+    {
+        for (int i = 0; i < ptrs.size(); i++)
+        {
+            if (i < 256 || (i >= 1000 && i < 2000) || i % 2 == 0 || i >= ptrs.size() - 64)
+            {
+                array.Erase(ptrs[i]);
+                ptrs[i] = nullptr;
+            }
+        }
+        size_t index = 0;
+        for (int& value : array)
+        {
+            while (ptrs[index] == nullptr)
+            {
+                index++;
+            }
+            CHECK(&value == ptrs[index]);
+            index++;
+        }
+        for (; index < ptrs.size(); index++)
+        {
+            CHECK(ptrs[index] == nullptr);
+        }
+    }
+
+    SUBCASE("Clear() reuses blocks")
+    {
+        array.Clear();
+        for (int& value : array)
+        {
+            CHECK(false);
+        }
+        for (int i = 0; i < ptrs.size(); i++)
+        {
+            CHECK(array.Push(i) == ptrs[i]);
+        }
+        CHECK(array.blocks.size == 100);
+    }
+
+    arena.Free();
+}
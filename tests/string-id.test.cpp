@@ -0,0 +1,44 @@
+#include "string-id.hpp"
+#include <doctest.h>
+
+TEST_CASE("String Id")
+{
+    SUBCASE("Literal ids match runtime ids")
+    {
+        constexpr StringId id = "left_eyebrow_angle"_id;
+        static_assert(id == StringId("left_eyebrow_angle"));
+
+        MemoryArena arena;
+        arena.Init(64, MemoryArenaFlags_ClearToZero);
+        String name = String::Copy("left_eyebrow", &arena);
+        name += "_angle";
+        CHECK(StringId(name) == id);
+        CHECK(StringId(name) != "right_eyebrow_angle"_id);
+        arena.Free();
+    }
+
+    SUBCASE("Interning")
+    {
+        CHECK(StringId("never_interned").GetString().size == 0);
+
+        StringId id = StringId::Intern("player");
+        CHECK(id == "player"_id);
+        CHECK(id.GetString() == "player");
+        CHECK(StringId::Intern("player") == id);
+    }
+
+    SUBCASE("Ids as hash map keys")
+    {
+        MemoryArena arena;
+        arena.Init(1024, MemoryArenaFlags_ClearToZero);
+
+        HashMap<StringId, int> map;
+        map.arena = &arena;
+        map.Insert("a"_id, 1);
+        map.Insert("b"_id, 2);
+        CHECK(*map.Find("a"_id) == 1);
+        CHECK(*map.Find(StringId("b")) == 2);
+        CHECK(map.Find("c"_id) == nullptr);
+        arena.Free();
+    }
+}
@@ -181,3 +181,59 @@ TEST_CASE("String View")
         CHECK_FALSE(StringView("abcdef").EndsWith("e"));
     }
 }
+
+TEST_CASE("Small String")
+{
+    MemoryArena arena;
+    arena.Init(1024, MemoryArenaFlags_ClearToZero);
+
+    MemoryPool pool;
+    pool.arena = &arena;
+
+    SmallString str;
+    str.pool = &pool;
+
+    SUBCASE("Short strings stay inline")
+    {
+        str += "Ground_0";
+        CHECK(str == "Ground_0");
+        CHECK(str.capacity == 0);
+        CHECK(str.Data() == str.inlineData);
+        CHECK(arena.offset == 0);
+
+        SmallString copy = str;
+        CHECK(copy == "Ground_0");
+        CHECK(copy.Data() == copy.inlineData);
+    }
+
+    SUBCASE("Long strings spill to the pool")
+    {
+        str += "A name that is longer than";
+        str += " the inline capacity";
+        CHECK(str == "A name that is longer than the inline capacity");
+        CHECK(str.capacity >= str.size);
+
+        str.Clear();
+        str += "Short again";
+        CHECK(str == "Short again");
+
+        str.Free();
+        CHECK(str.capacity == 0);
+        CHECK(str.size == 0);
+        CHECK(str == "");
+    }
+
+    SUBCASE("Spilled blocks are recycled")
+    {
+        str += "A name that is longer than the inline capacity";
+        char* data = str.Data();
+        str.Free();
+
+        SmallString other;
+        other.pool = &pool;
+        other += "Another name that spills out of the struct";
+        CHECK(other.Data() == data);
+    }
+
+    arena.Free();
+}
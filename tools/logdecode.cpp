@@ -0,0 +1,56 @@
+// Turns a binary log written with Log::StartBinaryLog() back into text
+// Usage: logdecode <binary log> [output file]
+
+#include <cstdio>
+
+#include "data-structures.hpp"
+#include "log-binary.hpp"
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <binary log> [output file]\n", argv[0]);
+        return 1;
+    }
+
+    FILE* input = fopen(argv[1], "rb");
+    if (input == nullptr)
+    {
+        fprintf(stderr, "Could not open '%s'\n", argv[1]);
+        return 1;
+    }
+    fseek(input, 0, SEEK_END);
+    size_t size = ftell(input);
+    fseek(input, 0, SEEK_SET);
+
+    MemoryArena arena;
+    arena.Init(size * 8 + 1024 * 1024, MemoryArenaFlags_VirtualMemory);
+
+    uint8_t* data = arena.Alloc<uint8_t>(size);
+    size_t bytesRead = fread(data, sizeof(uint8_t), size, input);
+    fclose(input);
+
+    String output;
+    output.arena = &arena;
+    bool success = Log::Binary::Decode(Span<const uint8_t>(data, bytesRead), output);
+
+    FILE* outputFile = argc >= 3 ? fopen(argv[2], "wb") : stdout;
+    if (outputFile == nullptr)
+    {
+        fprintf(stderr, "Could not open '%s'\n", argv[2]);
+        return 1;
+    }
+    fwrite(output.data, sizeof(char), output.size, outputFile);
+    if (outputFile != stdout)
+    {
+        fclose(outputFile);
+    }
+
+    if (!success)
+    {
+        fprintf(stderr, "'%s' is not a valid binary log, or is cut off. Decoded %zu bytes of text before the error\n", argv[1], output.size);
+        return 1;
+    }
+    return 0;
+}
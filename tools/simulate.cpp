@@ -0,0 +1,372 @@
+// Steps levels without a window or GPU, to benchmark and regression test physics on any machine
+// Usage: simulate [-j threads] [-n frames] [-v | -q] <scene> <input script> [<scene> <input script> ...]
+//
+// Input scripts are text, one line per stretch of frames: the frame count, then the keys held throughout it.
+// Keys are the names in KeyNames, and are pressed on the first frame of a stretch that didn't hold them before:
+//     # Run right and jump once
+//     30 Right
+//     1 Right Jump
+//     60 Right
+// Without -n, every pair runs for as many frames as its script lasts. With -n, shorter scripts hold nothing
+// for the remaining frames. Each scene/script pair is a job, jobs are spread over -j threads (default: all cores).
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "data-structures.hpp"
+#include "log.hpp"
+#include "simulation.hpp"
+
+MemoryArena GlobalArena;
+MemoryArena TransientArena;
+
+struct ScriptStretch
+{
+    uint32_t frames = 0;
+    // Bit i is set while Key(i) is held
+    uint32_t keys = 0;
+};
+
+struct Job
+{
+    const char* scenePath = nullptr;
+    const char* scriptPath = nullptr;
+
+    bool success = false;
+
+    uint32_t frames = 0;
+    // First frame the exit was reached on, or UINT32_MAX
+    uint32_t finishedFrame = UINT32_MAX;
+
+    double totalMs = 0.0;
+    double minFrameUs = 0.0;
+    double maxFrameUs = 0.0;
+    double p99FrameUs = 0.0;
+
+    Math::float2 position = 0.0f;
+    Math::float2 velocity = 0.0f;
+    Math::float2 gravityDirection = 0.0f;
+};
+
+// Config and the transient arena are global, so only one scene is loaded at a time. Stepping is independent per job
+static std::mutex s_LoadMutex;
+
+static bool ReadTextFile(const char* path, MemoryArena* arena, StringView& text)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr)
+    {
+        Log::Error("Could not open '%'", StringView(path));
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    size_t size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char* data = arena->Alloc<char>(size + 1);
+    size = fread(data, sizeof(char), size, file);
+    data[size] = '\0';
+    fclose(file);
+
+    text = StringView(data, size);
+    return true;
+}
+
+static bool ParseScript(const char* path, StringView text, Array<ScriptStretch>& script)
+{
+    int lineNumber = 0;
+    const char* line = text.data;
+    const char* end = text.data + text.size;
+    while (line < end)
+    {
+        lineNumber++;
+        const char* lineEnd = (const char*)memchr(line, '\n', end - line);
+        if (lineEnd == nullptr)
+        {
+            lineEnd = end;
+        }
+
+        ScriptStretch stretch;
+        bool hasFrames = false;
+        const char* cursor = line;
+        while (cursor < lineEnd && *cursor != '#')
+        {
+            if (isspace((unsigned char)*cursor))
+            {
+                cursor++;
+                continue;
+            }
+            const char* wordStart = cursor;
+            while (cursor < lineEnd && !isspace((unsigned char)*cursor) && *cursor != '#')
+            {
+                cursor++;
+            }
+            StringView word(wordStart, cursor - wordStart);
+
+            if (!hasFrames)
+            {
+                char* numberEnd = nullptr;
+                long frames = strtol(wordStart, &numberEnd, 10);
+                if (numberEnd != cursor || frames < 0)
+                {
+                    Log::Error("%:%: Expected a frame count, got '%'", StringView(path), lineNumber, word);
+                    return false;
+                }
+                stretch.frames = (uint32_t)frames;
+                hasFrames = true;
+                continue;
+            }
+
+            auto key = std::find(KeyNames.begin(), KeyNames.end(), word);
+            if (key == KeyNames.end())
+            {
+                Log::Error("%:%: Unknown key '%'", StringView(path), lineNumber, word);
+                return false;
+            }
+            stretch.keys |= 1u << (key - KeyNames.begin());
+        }
+
+        if (hasFrames)
+        {
+            script.Push(stretch);
+        }
+        line = lineEnd + 1;
+    }
+    return true;
+}
+
+// Prefers a scancode no other key is bound to, since the default controls share W and Up between Up and Jump
+static SDL_Scancode GetScriptScancode(const Input& input, Key key)
+{
+    for (SDL_Scancode scancode : input.controls[(int)key])
+    {
+        bool shared = false;
+        for (int other = 0; other < (int)Key::Count; other++)
+        {
+            const auto& controls = input.controls[other];
+            if (other != (int)key && std::find(controls.begin(), controls.end(), scancode) != controls.end())
+            {
+                shared = true;
+            }
+        }
+        if (scancode != SDL_SCANCODE_UNKNOWN && !shared)
+        {
+            return scancode;
+        }
+    }
+    return input.controls[(int)key][0];
+}
+
+static void SetHeldKeys(Input& input, uint32_t previousKeys, uint32_t keys)
+{
+    for (int key = 0; key < (int)Key::Count; key++)
+    {
+        uint32_t mask = 1u << key;
+        if ((previousKeys & mask) == (keys & mask))
+        {
+            continue;
+        }
+        SDL_Event event{};
+        event.type = keys & mask ? SDL_EVENT_KEY_DOWN : SDL_EVENT_KEY_UP;
+        event.key.scancode = GetScriptScancode(input, (Key)key);
+        input.OnEvent(event);
+    }
+}
+
+static void RunJob(Job& job, Scene& scene, MemoryArena& arena, uint32_t frameOverride)
+{
+    arena.Clear();
+
+    Array<ScriptStretch> script;
+    script.arena = &arena;
+    StringView scriptText;
+    if (!ReadTextFile(job.scriptPath, &arena, scriptText) || !ParseScript(job.scriptPath, scriptText, script))
+    {
+        return;
+    }
+
+    StringView sceneText;
+    if (!ReadTextFile(job.scenePath, &arena, sceneText))
+    {
+        return;
+    }
+    scene.Clear();
+    {
+        std::lock_guard lock(s_LoadMutex);
+        scene.Deserialize(sceneText);
+        TransientArena.Clear();
+    }
+
+    Player player(Simulation::SpawnPlayer(scene));
+    Camera camera;
+    Input input;
+
+    uint32_t scriptFrames = 0;
+    for (const ScriptStretch& stretch : script)
+    {
+        scriptFrames += stretch.frames;
+    }
+    job.frames = frameOverride != 0 ? frameOverride : scriptFrames;
+
+    Array<double> frameUs;
+    frameUs.arena = &arena;
+    frameUs.Resize(job.frames);
+
+    size_t stretchIndex = 0;
+    uint32_t stretchFrame = 0;
+    uint32_t heldKeys = 0;
+    for (uint32_t frame = 0; frame < job.frames; frame++)
+    {
+        while (stretchIndex < script.size && stretchFrame == script[stretchIndex].frames)
+        {
+            stretchIndex++;
+            stretchFrame = 0;
+        }
+        uint32_t keys = stretchIndex < script.size ? script[stretchIndex].keys : 0;
+        SetHeldKeys(input, heldKeys, keys);
+        heldKeys = keys;
+        stretchFrame++;
+
+        auto frameStart = std::chrono::steady_clock::now();
+        bool finishedLevel = Simulation::Step(scene, player, camera, input, (frame + 1) * Simulation::TimeStep);
+        input.EndFrame();
+        scene.EndFrame();
+        auto frameEnd = std::chrono::steady_clock::now();
+
+        frameUs[frame] = std::chrono::duration<double, std::micro>(frameEnd - frameStart).count();
+        if (finishedLevel && job.finishedFrame == UINT32_MAX)
+        {
+            job.finishedFrame = frame;
+        }
+    }
+
+    if (job.frames > 0)
+    {
+        for (double us : frameUs)
+        {
+            job.totalMs += us / 1000.0;
+        }
+        std::sort(frameUs.data, frameUs.data + frameUs.size);
+        job.minFrameUs = frameUs[0];
+        job.maxFrameUs = frameUs[job.frames - 1];
+        job.p99FrameUs = frameUs[(job.frames - 1) * 99 / 100];
+    }
+
+    job.position = player.GetTransform(scene).position;
+    job.velocity = player.velocity;
+    job.gravityDirection = player.gravityDirection;
+    job.success = true;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency());
+    uint32_t frameOverride = 0;
+
+    Array<Job> jobs;
+    jobs.arena = &GlobalArena;
+    GlobalArena.Init(1'048'576, MemoryArenaFlags_ClearToZero | MemoryArenaFlags_VirtualMemory);
+    TransientArena.Init(1'048'576, MemoryArenaFlags_ClearToZero | MemoryArenaFlags_VirtualMemory);
+
+    Array<const char*> paths;
+    paths.arena = &GlobalArena;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+        {
+            threadCount = std::max(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            frameOverride = (uint32_t)std::max(0, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-v") == 0)
+        {
+            Log::SetLogLevel(Log::LogLevel::Debug);
+        }
+        else if (strcmp(argv[i], "-q") == 0)
+        {
+            Log::SetLogLevel(Log::LogLevel::None);
+        }
+        else
+        {
+            paths.Push(argv[i]);
+        }
+    }
+    if (paths.size == 0 || paths.size % 2 != 0)
+    {
+        fprintf(stderr, "Usage: %s [-j threads] [-n frames] [-v | -q] <scene> <input script> [<scene> <input script> ...]\n", argv[0]);
+        return 1;
+    }
+    for (size_t i = 0; i < paths.size; i += 2)
+    {
+        jobs.Push(Job{ .scenePath = paths[i], .scriptPath = paths[i + 1] });
+    }
+    threadCount = std::min<unsigned int>(threadCount, jobs.size);
+
+    // Workers log from several threads at once, which the async writer's queue is made for
+    Log::StartAsyncWriter();
+
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> nextJob = 0;
+    auto Worker = [&]
+    {
+        Scene scene;
+        scene.Init();
+        MemoryArena arena;
+        arena.Init(1'048'576, MemoryArenaFlags_VirtualMemory);
+
+        for (size_t jobIndex = nextJob++; jobIndex < jobs.size; jobIndex = nextJob++)
+        {
+            RunJob(jobs[jobIndex], scene, arena, frameOverride);
+        }
+        arena.Free();
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < threadCount; i++)
+    {
+        threads.emplace_back(Worker);
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    Log::StopAsyncWriter();
+
+    // Reported in command line order once everything has finished, so the output can be diffed between runs
+    int failedCount = 0;
+    uint64_t totalFrames = 0;
+    for (const Job& job : jobs)
+    {
+        if (!job.success)
+        {
+            printf("%s %s: failed\n", job.scenePath, job.scriptPath);
+            failedCount++;
+            continue;
+        }
+        totalFrames += job.frames;
+        printf("%s %s: %u frames in %.3f ms (mean %.2f us, min %.2f us, p99 %.2f us, max %.2f us)\n",
+            job.scenePath, job.scriptPath, job.frames, job.totalMs,
+            job.frames > 0 ? job.totalMs * 1000.0 / job.frames : 0.0, job.minFrameUs, job.p99FrameUs, job.maxFrameUs);
+        printf("    position (%.6f, %.6f) velocity (%.6f, %.6f) gravity (%.6f, %.6f)",
+            job.position.x, job.position.y, job.velocity.x, job.velocity.y, job.gravityDirection.x, job.gravityDirection.y);
+        if (job.finishedFrame != UINT32_MAX)
+        {
+            printf(" finished on frame %u", job.finishedFrame);
+        }
+        printf("\n");
+    }
+    printf("%zu jobs, %llu frames on %u threads in %.3f ms\n", jobs.size, (unsigned long long)totalFrames, threadCount, wallMs);
+
+    return failedCount == 0 ? 0 : 1;
+}